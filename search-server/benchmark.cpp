@@ -0,0 +1,1074 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <csignal>
+#include <execution>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "binary_io.h"
+#include "document_order.h"
+#include "durable_search_server.h"
+#include "impact_kernels.h"
+#include "metrics.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "search_server.h"
+#include "shard_process.h"
+#include "sharded_search_server.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    size_t GetHeapInUse() {
+        const struct mallinfo2 info = mallinfo2();
+        return info.uordblks + info.hblkhd;
+    }
+
+    std::chrono::nanoseconds Percentile(const std::vector<std::chrono::nanoseconds>& sorted, double fraction) {
+        if (sorted.empty()) {
+            return std::chrono::nanoseconds(0);
+        }
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+    }
+
+    class LatencyRecorder {
+    public:
+        explicit LatencyRecorder(std::string name)
+            : name_(std::move(name))
+            , start_allocations_(GetMetricsSnapshot().GetCounter(MetricCounter::ALLOCATIONS))
+            , start_heap_(GetHeapInUse())
+            , peak_heap_(start_heap_) {
+        }
+
+        // The heap is sampled after every operation, outside the timed region.
+        template <typename Operation>
+        void Measure(Operation operation) {
+            const auto start = Clock::now();
+            operation();
+            latencies_.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start));
+            peak_heap_ = std::max(peak_heap_, GetHeapInUse());
+        }
+
+        // Throughput is computed from the summed latencies, so setup between
+        // measured operations does not count.
+        BenchmarkResult Finish() {
+            return Finish(latencies_.size());
+        }
+
+        BenchmarkResult Finish(size_t operations) {
+            const uint64_t allocations = GetMetricsSnapshot().GetCounter(MetricCounter::ALLOCATIONS) - start_allocations_;
+            std::sort(latencies_.begin(), latencies_.end());
+
+            std::chrono::nanoseconds total(0);
+            for (auto latency : latencies_) {
+                total += latency;
+            }
+
+            BenchmarkResult result;
+            result.name = name_;
+            result.operations = operations;
+            result.operations_per_second = total.count() == 0 ? 0.0 : result.operations * 1e9 / total.count();
+            result.p50 = Percentile(latencies_, 0.5);
+            result.p99 = Percentile(latencies_, 0.99);
+            result.p999 = Percentile(latencies_, 0.999);
+            result.max = latencies_.empty() ? std::chrono::nanoseconds(0) : latencies_.back();
+            result.peak_heap_kb = (std::max(peak_heap_, GetHeapInUse()) - start_heap_) / 1024;
+            result.allocations_per_operation = operations == 0 ? 0.0 : static_cast<double>(allocations) / operations;
+            return result;
+        }
+
+    private:
+        std::string name_;
+        uint64_t start_allocations_;
+        size_t start_heap_;
+        size_t peak_heap_;
+        std::vector<std::chrono::nanoseconds> latencies_;
+    };
+
+    // Shards of the sharded benchmarks and checks.
+    const size_t SHARD_COUNT = 4;
+
+    template <typename Server>
+    void AddCorpus(Server& search_server, const std::vector<GeneratedDocument>& corpus) {
+        for (const GeneratedDocument& document : corpus) {
+            search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+    }
+
+    // Documents of 20 to 40 words found nowhere else, so each has relevance
+    // ln(document_count) for a query of its own words.
+    std::vector<GeneratedDocument> GenerateRareWordCorpus(size_t document_count) {
+        std::vector<GeneratedDocument> corpus(document_count);
+        for (size_t i = 0; i < document_count; ++i) {
+            GeneratedDocument& document = corpus[i];
+            document.id = static_cast<int>(i);
+            for (size_t j = 0; j < 20 + i % 21; ++j) {
+                document.text += (j == 0 ? "r"s : " r"s) + std::to_string(i) + "x"s + std::to_string(j);
+            }
+            document.ratings = { static_cast<int>(i % 11) - 5 };
+        }
+        return corpus;
+    }
+
+    std::string GetImpactEncodingName(ImpactEncoding encoding) {
+        return encoding == ImpactEncoding::FLOAT32 ? "f32"s : "u16"s;
+    }
+
+    std::vector<int> GetSampleDocumentIds(const std::vector<GeneratedDocument>& corpus, size_t count) {
+        std::vector<int> ids;
+        if (corpus.empty()) {
+            return ids;
+        }
+        const size_t step = std::max<size_t>(1, corpus.size() / std::max<size_t>(1, count));
+        for (size_t i = 0; i < corpus.size() && ids.size() < count; i += step) {
+            ids.push_back(corpus[i].id);
+        }
+        return ids;
+    }
+
+    void RemoveIndexFiles(const std::string& directory) {
+        for (const std::string& path : { DurableSearchServer::GetSnapshotPath(directory),
+                DurableSearchServer::GetSnapshotPath(directory) + ".tmp"s, DurableSearchServer::GetLogPath(directory) }) {
+            unlink(path.c_str());
+        }
+    }
+
+    std::string GetDurabilityName(Durability durability) {
+        switch (durability) {
+        case Durability::NONE:
+            return "none"s;
+        case Durability::GROUP:
+            return "group"s;
+        default:
+            return "sync"s;
+        }
+    }
+
+    // Same relevance at every rank and the same documents, where documents
+    // tied within MAX_DIFFERENCE may come in any order. The last tie group may
+    // continue past the end of the results, so it may hold different documents.
+    bool HaveSameRanking(const std::vector<Document>& expected, const std::vector<Document>& actual) {
+        if (expected.size() != actual.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < expected.size(); ++i) {
+            if (std::abs(expected[i].relevance - actual[i].relevance) >= MAX_DIFFERENCE) {
+                return false;
+            }
+        }
+        size_t group_begin = 0;
+        while (group_begin < expected.size()) {
+            size_t group_end = group_begin + 1;
+            while (group_end < expected.size()
+                && std::abs(expected[group_end].relevance - expected[group_begin].relevance) < MAX_DIFFERENCE) {
+                ++group_end;
+            }
+            if (group_end == expected.size()) {
+                break;
+            }
+            std::vector<int> expected_ids;
+            std::vector<int> actual_ids;
+            for (size_t i = group_begin; i < group_end; ++i) {
+                expected_ids.push_back(expected[i].id);
+                actual_ids.push_back(actual[i].id);
+            }
+            std::sort(expected_ids.begin(), expected_ids.end());
+            std::sort(actual_ids.begin(), actual_ids.end());
+            if (expected_ids != actual_ids) {
+                return false;
+            }
+            group_begin = group_end;
+        }
+        return true;
+    }
+
+    // Checks a UINT16 impact index built in document_order: the raw quantized
+    // score of every matching document must be within the documented error of
+    // its exact relevance, max_impact / 131070 per query word plus float
+    // rounding, and the rescored top documents must rank as in the reference.
+    int CheckQuantizedRanking(const SearchServer& reference_server, const SearchServer& impact_server,
+        const std::vector<int>& document_order, const std::vector<std::string>& queries, const std::string& name,
+        std::ostream& out) {
+        const ImpactIndex& impact_index = *impact_server.GetImpactIndex();
+        std::map<int, uint32_t> document_ordinals;
+        for (size_t i = 0; i < document_order.size(); ++i) {
+            document_ordinals[document_order[i]] = static_cast<uint32_t>(i);
+        }
+
+        int mismatches = 0;
+        double worst_error_ratio = 0.0;
+        for (const std::string& query : queries) {
+            std::set<std::string_view> plus_words;
+            for (std::string_view word : SplitIntoWords(query)) {
+                if (!word.empty() && word[0] != '-') {
+                    plus_words.insert(word);
+                }
+            }
+            std::vector<float> scores(document_order.size(), 0.0f);
+            double impact_error = 0.0;
+            double max_score = 0.0;
+            for (std::string_view word : plus_words) {
+                if (const ImpactPostings* postings = impact_index.FindPostings(word)) {
+                    impact_index.Accumulate(*postings, scores.data());
+                    impact_error += impact_index.GetImpactError(*postings);
+                    max_score += postings->max_impact;
+                }
+            }
+            const double error_bound = impact_error + plus_words.size() * max_score * FLT_EPSILON;
+
+            bool within_bound = true;
+            const DocumentPage all_matches = reference_server.FindTopDocuments(query, SearchCursor(),
+                std::numeric_limits<size_t>::max());
+            for (const Document& document : all_matches.documents) {
+                const double error = std::abs(scores[document_ordinals.at(document.id)] - document.relevance);
+                worst_error_ratio = std::max(worst_error_ratio, error_bound > 0.0 ? error / error_bound : 0.0);
+                within_bound = within_bound && error <= error_bound;
+            }
+            if (!within_bound || !HaveSameRanking(reference_server.FindTopDocuments(query), impact_server.FindTopDocuments(query))) {
+                if (mismatches == 0) {
+                    out << "Quantized impact ranking differs for query: "s << query << std::endl;
+                }
+                ++mismatches;
+            }
+        }
+        out << "Impact ranking ("s << GetImpactKernelName() << ", u16, "s << name << "): "s << queries.size()
+            << " queries, "s << mismatches << " mismatches, worst error = "s << worst_error_ratio << " of bound"s << std::endl;
+        return mismatches;
+    }
+
+    // Runs in the forked child: acknowledges every durable AddDocument by
+    // writing the id to the pipe, then waits to be killed.
+    [[noreturn]] void RunCrashingWriter(const BenchmarkOptions& options, const std::string& directory,
+        const std::vector<GeneratedDocument>& corpus, int ack_fd) {
+        try {
+            DurableSearchServer durable_server(directory, GenerateStopWords(options.stop_word_count), Durability::GROUP);
+            for (size_t i = 0; i < corpus.size(); ++i) {
+                if (i == corpus.size() / 4) {
+                    durable_server.Checkpoint();
+                }
+                durable_server.AddDocument(corpus[i].id, corpus[i].text, corpus[i].status, corpus[i].ratings);
+                WriteAll(ack_fd, std::string_view(reinterpret_cast<const char*>(&corpus[i].id), sizeof(int)));
+            }
+        }
+        catch (...) {
+            _exit(1);
+        }
+        while (true) {
+            pause();
+        }
+    }
+
+    // Runs in a forked child so that the file size limit stays there: the log
+    // starts failing partway through concurrent GROUP writes, and afterwards
+    // both the live index and the reopened one must hold exactly the
+    // acknowledged documents. Exits with the number of failed checks.
+    [[noreturn]] void RunFailingWriters(const BenchmarkOptions& options, const std::string& directory,
+        const std::vector<GeneratedDocument>& corpus, std::ostream& out) {
+        int failures = 0;
+        try {
+            const std::string stop_words = GenerateStopWords(options.stop_word_count);
+            const size_t writer_threads = std::max<size_t>(1, options.writer_threads);
+            std::set<int> acknowledged_ids;
+            size_t rejected = 0;
+            std::mutex ids_mutex;
+            signal(SIGXFSZ, SIG_IGN);
+            {
+                DurableSearchServer durable_server(directory, stop_words, Durability::GROUP);
+                rlimit file_size_limit{};
+                file_size_limit.rlim_cur = 64 * 1024;
+                file_size_limit.rlim_max = RLIM_INFINITY;
+                setrlimit(RLIMIT_FSIZE, &file_size_limit);
+                std::vector<std::thread> writers;
+                for (size_t thread_index = 0; thread_index < writer_threads; ++thread_index) {
+                    writers.emplace_back([&, thread_index] {
+                        for (size_t i = thread_index; i < corpus.size(); i += writer_threads) {
+                            try {
+                                durable_server.AddDocument(corpus[i].id, corpus[i].text, corpus[i].status, corpus[i].ratings);
+                                std::lock_guard lock(ids_mutex);
+                                acknowledged_ids.insert(corpus[i].id);
+                            }
+                            catch (const std::exception&) {
+                                std::lock_guard lock(ids_mutex);
+                                ++rejected;
+                            }
+                            if (i % 5 == 0) {
+                                try {
+                                    durable_server.RemoveDocument(corpus[i].id);
+                                    std::lock_guard lock(ids_mutex);
+                                    acknowledged_ids.erase(corpus[i].id);
+                                }
+                                catch (const std::exception&) {
+                                }
+                            }
+                        }
+                    });
+                }
+                for (std::thread& writer : writers) {
+                    writer.join();
+                }
+                const SearchServer& search_server = durable_server.GetSearchServer();
+                if (std::set<int>(search_server.begin(), search_server.end()) != acknowledged_ids) {
+                    out << "After the log failed the index holds unacknowledged changes"s << std::endl;
+                    ++failures;
+                }
+                file_size_limit.rlim_cur = RLIM_INFINITY;
+                setrlimit(RLIMIT_FSIZE, &file_size_limit);
+            }
+            const DurableSearchServer reopened_server(directory, stop_words, Durability::NONE);
+            const SearchServer& recovered = reopened_server.GetSearchServer();
+            if (std::set<int>(recovered.begin(), recovered.end()) != acknowledged_ids) {
+                out << "The reopened index differs from the acknowledged documents"s << std::endl;
+                ++failures;
+            }
+            if (rejected == 0) {
+                out << "The log never failed"s << std::endl;
+                ++failures;
+            }
+            out << "Log failure: "s << acknowledged_ids.size() << " acknowledged, "s << rejected
+                << " rejected, "s << failures << " failures"s << std::endl;
+        }
+        catch (const std::exception& e) {
+            out << "Log failure check: "s << e.what() << std::endl;
+            ++failures;
+        }
+        out.flush();
+        _exit(failures);
+    }
+
+    template <typename Remove>
+    BenchmarkResult BenchmarkRemove(const std::string& name, const BenchmarkOptions& options,
+        const std::vector<GeneratedDocument>& corpus, Remove remove) {
+        SearchServer search_server(GenerateStopWords(options.stop_word_count));
+        AddCorpus(search_server, corpus);
+        LatencyRecorder recorder(name);
+        for (int document_id : GetSampleDocumentIds(corpus, options.remove_count)) {
+            recorder.Measure([&] { remove(search_server, document_id); });
+        }
+        return recorder.Finish();
+    }
+
+}
+
+std::vector<BenchmarkResult> RunBenchmarks(const BenchmarkOptions& options)
+{
+    const std::vector<GeneratedDocument> corpus = GenerateCorpus(options.corpus);
+    QueryLogOptions query_options = options.queries;
+    query_options.vocabulary_size = options.corpus.vocabulary_size;
+    const std::vector<std::string> queries = GenerateQueries(query_options);
+    const std::string stop_words = GenerateStopWords(options.stop_word_count);
+
+    std::vector<BenchmarkResult> results;
+
+    SearchServer search_server(stop_words);
+    {
+        LatencyRecorder recorder("AddDocument"s);
+        for (const GeneratedDocument& document : corpus) {
+            recorder.Measure([&] { search_server.AddDocument(document.id, document.text, document.status, document.ratings); });
+        }
+        results.push_back(recorder.Finish());
+    }
+    {
+        LatencyRecorder recorder("BulkIngest"s);
+        std::unique_ptr<SearchServer> bulk_server;
+        recorder.Measure([&] {
+            bulk_server = std::make_unique<SearchServer>(stop_words);
+            AddCorpus(*bulk_server, corpus);
+        });
+        results.push_back(recorder.Finish(corpus.size()));
+    }
+    {
+        LatencyRecorder recorder("FindTopDocuments/seq"s);
+        for (const std::string& query : queries) {
+            recorder.Measure([&] { search_server.FindTopDocuments(std::execution::seq, query); });
+        }
+        results.push_back(recorder.Finish());
+    }
+    {
+        LatencyRecorder recorder("FindTopDocuments/par"s);
+        for (const std::string& query : queries) {
+            recorder.Measure([&] { search_server.FindTopDocuments(std::execution::par, query); });
+        }
+        results.push_back(recorder.Finish());
+    }
+    for (bool process_shards : { false, true }) {
+        const auto sharded_server = process_shards
+            ? std::make_unique<ShardedSearchServer>(MakeProcessShards(SHARD_COUNT, stop_words))
+            : std::make_unique<ShardedSearchServer>(SHARD_COUNT, stop_words);
+        AddCorpus(*sharded_server, corpus);
+        LatencyRecorder recorder(process_shards ? "FindTopDocuments/sharded-process"s : "FindTopDocuments/sharded-local"s);
+        for (const std::string& query : queries) {
+            recorder.Measure([&] { sharded_server->FindTopDocuments(query); });
+        }
+        results.push_back(recorder.Finish());
+    }
+    for (bool minhash_order : { false, true }) {
+        SearchServer impact_server(stop_words);
+        AddCorpus(impact_server, corpus);
+        const std::vector<int> document_order = minhash_order
+            ? ComputeMinHashOrder(impact_server)
+            : std::vector<int>(impact_server.begin(), impact_server.end());
+        for (ImpactEncoding encoding : { ImpactEncoding::FLOAT32, ImpactEncoding::UINT16 }) {
+            impact_server.BuildImpactIndex(encoding, document_order);
+            LatencyRecorder recorder("FindTopDocuments/impact-"s + GetImpactEncodingName(encoding)
+                + (minhash_order ? "-minhash"s : ""s));
+            for (const std::string& query : queries) {
+                recorder.Measure([&] { impact_server.FindTopDocuments(query); });
+            }
+            results.push_back(recorder.Finish());
+        }
+    }
+
+    const std::vector<int> match_ids = GetSampleDocumentIds(corpus, options.match_count);
+    {
+        LatencyRecorder recorder("MatchDocument/seq"s);
+        for (size_t i = 0; i < match_ids.size() && !queries.empty(); ++i) {
+            recorder.Measure([&] { search_server.MatchDocument(std::execution::seq, queries[i % queries.size()], match_ids[i]); });
+        }
+        results.push_back(recorder.Finish());
+    }
+    {
+        LatencyRecorder recorder("MatchDocument/par"s);
+        for (size_t i = 0; i < match_ids.size() && !queries.empty(); ++i) {
+            recorder.Measure([&] { search_server.MatchDocument(std::execution::par, queries[i % queries.size()], match_ids[i]); });
+        }
+        results.push_back(recorder.Finish());
+    }
+    {
+        LatencyRecorder recorder("ProcessQueries"s);
+        LatencyRecorder joined_recorder("ProcessQueriesJoined"s);
+        for (size_t begin = 0; begin < queries.size(); begin += options.batch_size) {
+            const std::vector<std::string> batch(queries.begin() + begin,
+                queries.begin() + std::min(queries.size(), begin + options.batch_size));
+            recorder.Measure([&] { ProcessQueries(search_server, batch); });
+            joined_recorder.Measure([&] { ProcessQueriesJoined(search_server, batch); });
+        }
+        results.push_back(recorder.Finish(queries.size()));
+        results.push_back(joined_recorder.Finish(queries.size()));
+    }
+
+    results.push_back(BenchmarkRemove("RemoveDocument/seq"s, options, corpus,
+        [](SearchServer& server, int document_id) { server.RemoveDocument(std::execution::seq, document_id); }));
+    results.push_back(BenchmarkRemove("RemoveDocument/par"s, options, corpus,
+        [](SearchServer& server, int document_id) { server.RemoveDocument(std::execution::par, document_id); }));
+
+    {
+        SearchServer duplicates_server(stop_words);
+        AddCorpus(duplicates_server, corpus);
+        LatencyRecorder recorder("RemoveDuplicates"s);
+        std::ostringstream discarded;
+        auto* const cout_buffer = std::cout.rdbuf(discarded.rdbuf());
+        recorder.Measure([&] { RemoveDuplicates(duplicates_server); });
+        std::cout.rdbuf(cout_buffer);
+        results.push_back(recorder.Finish(corpus.size()));
+    }
+
+    return results;
+}
+
+int CheckImpactRanking(const BenchmarkOptions& options, std::ostream& out)
+{
+    const std::vector<GeneratedDocument> corpus = GenerateCorpus(options.corpus);
+    QueryLogOptions query_options = options.queries;
+    query_options.vocabulary_size = options.corpus.vocabulary_size;
+    const std::vector<std::string> queries = GenerateQueries(query_options);
+    const std::string stop_words = GenerateStopWords(options.stop_word_count);
+
+    SearchServer reference_server(stop_words);
+    AddCorpus(reference_server, corpus);
+    SearchServer impact_server(stop_words);
+    AddCorpus(impact_server, corpus);
+
+    int mismatches = 0;
+    for (bool minhash_order : { false, true }) {
+        const std::vector<int> document_order = minhash_order
+            ? ComputeMinHashOrder(impact_server)
+            : std::vector<int>(impact_server.begin(), impact_server.end());
+        impact_server.BuildImpactIndex(ImpactEncoding::FLOAT32, document_order);
+        const PostingGapStatistics gaps = impact_server.GetImpactIndex()->GetGapStatistics();
+
+        int order_mismatches = 0;
+        for (const std::string& query : queries) {
+            const std::vector<Document> expected = reference_server.FindTopDocuments(query);
+            const std::vector<Document> actual = impact_server.FindTopDocuments(query);
+            if (!HaveSameRanking(expected, actual)) {
+                if (order_mismatches == 0) {
+                    out << "Impact ranking differs for query: "s << query << std::endl;
+                }
+                ++order_mismatches;
+            }
+        }
+        out << "Impact ranking ("s << GetImpactKernelName() << (minhash_order ? ", minhash order"s : ", id order"s)
+            << "): "s << queries.size() << " queries, "s << order_mismatches << " mismatches, "s
+            << gaps.postings << " postings, "s << gaps.varint_bytes << " varint bytes, "s
+            << "average log2 gap = "s << gaps.average_log2_gap << std::endl;
+        mismatches += order_mismatches;
+    }
+
+    const std::vector<int> id_order(impact_server.begin(), impact_server.end());
+    impact_server.BuildImpactIndex(ImpactEncoding::UINT16, id_order);
+    mismatches += CheckQuantizedRanking(reference_server, impact_server, id_order, queries, "id order"s, out);
+
+    // Relevances above 8, where float spacing is about 1e-6: float sums alone
+    // drift past MAX_DIFFERENCE here.
+    const std::vector<GeneratedDocument> rare_corpus = GenerateRareWordCorpus(5000);
+    SearchServer rare_reference_server(stop_words);
+    AddCorpus(rare_reference_server, rare_corpus);
+    SearchServer rare_impact_server(stop_words);
+    AddCorpus(rare_impact_server, rare_corpus);
+    rare_impact_server.BuildImpactIndex(ImpactEncoding::FLOAT32);
+    int rare_mismatches = 0;
+    size_t rare_queries = 0;
+    for (size_t i = 0; i < rare_corpus.size(); i += 25, ++rare_queries) {
+        const std::string& query = rare_corpus[i].text;
+        if (!HaveSameRanking(rare_reference_server.FindTopDocuments(query), rare_impact_server.FindTopDocuments(query))) {
+            if (rare_mismatches == 0) {
+                out << "Impact ranking differs for rare-word query: "s << query << std::endl;
+            }
+            ++rare_mismatches;
+        }
+    }
+    out << "Impact ranking ("s << GetImpactKernelName() << ", rare words): "s << rare_queries << " queries, "s
+        << rare_mismatches << " mismatches"s << std::endl;
+    mismatches += rare_mismatches;
+
+    std::vector<std::string> rare_queries_text;
+    for (size_t i = 0; i < rare_corpus.size(); i += 25) {
+        rare_queries_text.push_back(rare_corpus[i].text);
+    }
+    const std::vector<int> rare_id_order(rare_impact_server.begin(), rare_impact_server.end());
+    rare_impact_server.BuildImpactIndex(ImpactEncoding::UINT16, rare_id_order);
+    mismatches += CheckQuantizedRanking(rare_reference_server, rare_impact_server, rare_id_order, rare_queries_text,
+        "rare words"s, out);
+    return mismatches;
+}
+
+int CheckShardedSearch(const BenchmarkOptions& options, std::ostream& out)
+{
+    const std::vector<GeneratedDocument> corpus = GenerateCorpus(options.corpus);
+    QueryLogOptions query_options = options.queries;
+    query_options.vocabulary_size = options.corpus.vocabulary_size;
+    const std::vector<std::string> queries = GenerateQueries(query_options);
+    const std::string stop_words = GenerateStopWords(options.stop_word_count);
+
+    SearchServer search_server(stop_words);
+    AddCorpus(search_server, corpus);
+    ShardedSearchServer local_server(SHARD_COUNT, stop_words);
+    AddCorpus(local_server, corpus);
+    ShardedSearchServer process_server(MakeProcessShards(SHARD_COUNT, stop_words));
+    AddCorpus(process_server, corpus);
+
+    // Removals change the document count and document frequencies the
+    // coordinator shares with the shards.
+    const std::vector<int> removed_ids = GetSampleDocumentIds(corpus, options.remove_count);
+    for (int document_id : removed_ids) {
+        search_server.RemoveDocument(document_id);
+        local_server.RemoveDocument(document_id);
+        process_server.RemoveDocument(document_id);
+    }
+    const std::set<int> removed(removed_ids.begin(), removed_ids.end());
+    const std::vector<int> match_ids = GetSampleDocumentIds(corpus, options.match_count);
+
+    int mismatches = 0;
+    for (bool process_shards : { false, true }) {
+        const ShardedSearchServer& sharded_server = process_shards ? process_server : local_server;
+        const std::string name = process_shards ? "process"s : "local"s;
+
+        int server_mismatches = sharded_server.GetDocumentCount() == search_server.GetDocumentCount() ? 0 : 1;
+        for (const std::string& query : queries) {
+            if (!HaveSameRanking(search_server.FindTopDocuments(query), sharded_server.FindTopDocuments(query))) {
+                if (server_mismatches == 0) {
+                    out << "Sharded ("s << name << ") ranking differs for query: "s << query << std::endl;
+                }
+                ++server_mismatches;
+            }
+        }
+        for (size_t i = 0; i < match_ids.size() && !queries.empty(); ++i) {
+            const std::string& query = queries[i % queries.size()];
+            bool same = false;
+            if (removed.count(match_ids[i]) > 0) {
+                try {
+                    sharded_server.MatchDocument(query, match_ids[i]);
+                }
+                catch (const std::out_of_range&) {
+                    same = true;
+                }
+            }
+            else {
+                auto [expected_words, expected_status] = search_server.MatchDocument(query, match_ids[i]);
+                auto [actual_words, actual_status] = sharded_server.MatchDocument(query, match_ids[i]);
+                std::sort(expected_words.begin(), expected_words.end());
+                std::sort(actual_words.begin(), actual_words.end());
+                same = expected_words == actual_words && expected_status == actual_status;
+            }
+            if (!same) {
+                if (server_mismatches == 0) {
+                    out << "Sharded ("s << name << ") match differs for document "s << match_ids[i]
+                        << " and query: "s << query << std::endl;
+                }
+                ++server_mismatches;
+            }
+        }
+        out << "Sharded search ("s << name << ", "s << sharded_server.GetShardCount() << " shards): "s
+            << queries.size() << " queries, "s << match_ids.size() << " matches, "s << removed.size()
+            << " removed documents, "s << server_mismatches << " mismatches"s << std::endl;
+        mismatches += server_mismatches;
+    }
+    return mismatches;
+}
+
+int CheckCursorPagination(const BenchmarkOptions& options, std::ostream& out)
+{
+    constexpr size_t WALK_LENGTH = 50;
+
+    const std::vector<GeneratedDocument> corpus = GenerateCorpus(options.corpus);
+    QueryLogOptions query_options = options.queries;
+    query_options.vocabulary_size = options.corpus.vocabulary_size;
+    const std::vector<std::string> queries = GenerateQueries(query_options);
+    SearchServer search_server(GenerateStopWords(options.stop_word_count));
+    AddCorpus(search_server, corpus);
+
+    int failures = 0;
+    for (size_t page_size : { 1, 7 }) {
+        int size_failures = 0;
+        for (const std::string& query : queries) {
+            const DocumentPage expected = search_server.FindTopDocuments(query, SearchCursor(), WALK_LENGTH + page_size);
+            std::vector<Document> walked;
+            SearchCursor cursor;
+            while (!cursor.IsEnd() && walked.size() < WALK_LENGTH) {
+                DocumentPage page = search_server.FindTopDocuments(query, cursor, page_size);
+                walked.insert(walked.end(), page.documents.begin(), page.documents.end());
+                cursor = page.next;
+            }
+            bool same = walked.size() <= expected.documents.size()
+                && (!cursor.IsEnd() || walked.size() == expected.documents.size());
+            for (size_t i = 0; same && i < walked.size(); ++i) {
+                same = walked[i].id == expected.documents[i].id && walked[i].relevance == expected.documents[i].relevance;
+            }
+            if (!same) {
+                if (size_failures == 0) {
+                    out << "Cursor pages of "s << page_size << " differ for query: "s << query << std::endl;
+                }
+                ++size_failures;
+            }
+        }
+        out << "Cursor pagination (page size "s << page_size << "): "s << queries.size() << " queries, "s
+            << size_failures << " mismatches"s << std::endl;
+        failures += size_failures;
+    }
+
+    // The first page and FindTopDocuments share one order, ties included. The
+    // parallel sum may differ in the last bits, so relevance gets a tolerance.
+    int first_page_failures = 0;
+    for (const std::string& query : queries) {
+        const DocumentPage page = search_server.FindTopDocuments(query, SearchCursor(), MAX_RESULT_DOCUMENT_COUNT);
+        for (const std::vector<Document>& top : { search_server.FindTopDocuments(std::execution::seq, query),
+                search_server.FindTopDocuments(std::execution::par, query) }) {
+            bool same = top.size() == page.documents.size();
+            for (size_t i = 0; same && i < top.size(); ++i) {
+                same = top[i].id == page.documents[i].id
+                    && std::abs(top[i].relevance - page.documents[i].relevance) < MAX_DIFFERENCE;
+            }
+            if (!same) {
+                if (first_page_failures == 0) {
+                    out << "First cursor page differs from FindTopDocuments for query: "s << query << std::endl;
+                }
+                ++first_page_failures;
+            }
+        }
+    }
+    out << "Cursor first page vs FindTopDocuments: "s << queries.size() << " queries, "s
+        << first_page_failures << " mismatches"s << std::endl;
+    failures += first_page_failures;
+
+    // 1 ties with 2 and 2 with 3 under an epsilon comparison, but 1 outranks 3.
+    const std::vector<Document> near_ties = { { 1, 1.0, 5 }, { 2, 1.0000008, 0 }, { 3, 1.0000016, 0 } };
+    std::vector<int> visited;
+    SearchCursor cursor;
+    while (visited.size() <= near_ties.size()) {
+        const Document* next = nullptr;
+        for (const Document& document : near_ties) {
+            if (cursor.Admits(document) && (next == nullptr || IsRankedBefore(document, *next))) {
+                next = &document;
+            }
+        }
+        if (next == nullptr) {
+            break;
+        }
+        visited.push_back(next->id);
+        cursor = SearchCursor::After(*next);
+    }
+    std::vector<int> sorted_visited = visited;
+    std::sort(sorted_visited.begin(), sorted_visited.end());
+    if (sorted_visited != std::vector<int>{ 1, 2, 3 }) {
+        out << "Cursor over near ties visits "s << visited.size() << " documents instead of 3"s << std::endl;
+        ++failures;
+    }
+    return failures;
+}
+
+int CheckQueryBudget(const BenchmarkOptions& options, std::ostream& out)
+{
+    const std::vector<GeneratedDocument> corpus = GenerateCorpus(options.corpus);
+    QueryLogOptions query_options = options.queries;
+    query_options.vocabulary_size = options.corpus.vocabulary_size;
+    const std::vector<std::string> queries = GenerateQueries(query_options);
+    SearchServer search_server(GenerateStopWords(options.stop_word_count));
+    AddCorpus(search_server, corpus);
+
+    CancellationSource cancelled_source;
+    cancelled_source.Cancel();
+
+    int failures = 0;
+    size_t expired_truncated = 0;
+    size_t cancelled_truncated = 0;
+    for (const std::string& query : queries) {
+        const std::vector<Document> expected = search_server.FindTopDocuments(query);
+        const DocumentPage all_matches = search_server.FindTopDocuments(query, SearchCursor(),
+            std::numeric_limits<size_t>::max());
+        std::map<int, double> full_relevance;
+        for (const Document& document : all_matches.documents) {
+            full_relevance[document.id] = document.relevance;
+        }
+        const auto is_valid = [&](const PartialResult& result) {
+            if (!result.truncated) {
+                return HaveSameRanking(expected, result.documents);
+            }
+            return std::all_of(result.documents.begin(), result.documents.end(), [&](const Document& document) {
+                const auto match = full_relevance.find(document.id);
+                return match != full_relevance.end() && document.relevance < match->second + MAX_DIFFERENCE;
+            });
+        };
+
+        const PartialResult unlimited = search_server.FindTopDocuments(query, QueryBudget());
+        const PartialResult expired = search_server.FindTopDocuments(query,
+            QueryBudget(QueryBudget::Clock::now() - std::chrono::seconds(1)));
+        const PartialResult cancelled = FindTopDocumentsAsync(search_server, query,
+            QueryBudget(QueryBudget::Clock::time_point::max(), cancelled_source.GetToken())).get();
+        expired_truncated += expired.truncated;
+        cancelled_truncated += cancelled.truncated;
+        if (unlimited.truncated || !is_valid(unlimited) || !is_valid(expired) || !is_valid(cancelled)) {
+            if (failures == 0) {
+                out << "Budgeted result is wrong for query: "s << query << std::endl;
+            }
+            ++failures;
+        }
+    }
+    // Every query gives up at its first budget check, and the common words of
+    // a Zipf corpus have far more postings than one block.
+    if (expired_truncated == 0 || cancelled_truncated != expired_truncated) {
+        out << "Exhausted budgets truncated "s << expired_truncated << " (deadline) and "s
+            << cancelled_truncated << " (cancelled) queries"s << std::endl;
+        ++failures;
+    }
+
+    std::string long_query;
+    for (const std::string& query : queries) {
+        long_query += (long_query.empty() ? ""s : " "s) + query;
+    }
+    const auto full_start = std::chrono::steady_clock::now();
+    search_server.FindTopDocuments(long_query, QueryBudget());
+    const auto full_time = std::chrono::steady_clock::now() - full_start;
+
+    CancellationSource source;
+    const auto cancel_start = std::chrono::steady_clock::now();
+    std::future<PartialResult> pending = FindTopDocumentsAsync(search_server, long_query,
+        QueryBudget(QueryBudget::Clock::time_point::max(), source.GetToken()));
+    source.Cancel();
+    const PartialResult interrupted = pending.get();
+    const auto cancel_time = std::chrono::steady_clock::now() - cancel_start;
+
+    out << "Query budget: "s << queries.size() << " queries, "s << expired_truncated << " truncated by deadline, "s
+        << cancelled_truncated << " by cancellation, "s << failures << " failures; long query "s
+        << std::chrono::duration_cast<std::chrono::microseconds>(full_time).count() << " us, cancelled after "s
+        << std::chrono::duration_cast<std::chrono::microseconds>(cancel_time).count() << " us"s
+        << (interrupted.truncated ? " (truncated)"s : " (completed)"s) << std::endl;
+    return failures;
+}
+
+void PrintIndexMemory(const BenchmarkOptions& options, std::ostream& out)
+{
+    const std::vector<GeneratedDocument> corpus = GenerateCorpus(options.corpus);
+    const std::string stop_words = GenerateStopWords(options.stop_word_count);
+    for (ForwardIndexEncoding encoding : { ForwardIndexEncoding::DISABLED, ForwardIndexEncoding::PLAIN,
+            ForwardIndexEncoding::VARINT }) {
+        const size_t heap_before = GetHeapInUse();
+        {
+            SearchServer search_server(stop_words);
+            search_server.SetForwardIndexEncoding(encoding);
+            AddCorpus(search_server, corpus);
+            out << "Index memory (forward index "s
+                << (encoding == ForwardIndexEncoding::DISABLED ? "disabled"s
+                    : encoding == ForwardIndexEncoding::PLAIN ? "plain"s : "varint"s)
+                << "): "s << (GetHeapInUse() - heap_before) / 1024 << " KiB"s << std::endl;
+        }
+    }
+}
+
+std::vector<BenchmarkResult> RunRecoveryBenchmarks(const BenchmarkOptions& options, const std::string& directory)
+{
+    const std::vector<GeneratedDocument> corpus = GenerateCorpus(options.corpus);
+    const std::string stop_words = GenerateStopWords(options.stop_word_count);
+    const size_t durable_count = std::min(options.durable_count, corpus.size());
+    const size_t writer_threads = std::max<size_t>(1, options.writer_threads);
+
+    std::vector<BenchmarkResult> results;
+    for (Durability durability : { Durability::NONE, Durability::GROUP, Durability::SYNC }) {
+        RemoveIndexFiles(directory);
+        DurableSearchServer durable_server(directory, stop_words, durability);
+        LatencyRecorder recorder("DurableAdd/"s + GetDurabilityName(durability));
+        recorder.Measure([&] {
+            std::vector<std::thread> writers;
+            for (size_t thread_index = 0; thread_index < writer_threads; ++thread_index) {
+                writers.emplace_back([&, thread_index] {
+                    for (size_t i = thread_index; i < durable_count; i += writer_threads) {
+                        durable_server.AddDocument(corpus[i].id, corpus[i].text, corpus[i].status, corpus[i].ratings);
+                    }
+                });
+            }
+            for (std::thread& writer : writers) {
+                writer.join();
+            }
+        });
+        results.push_back(recorder.Finish(durable_count));
+    }
+
+    RemoveIndexFiles(directory);
+    {
+        DurableSearchServer durable_server(directory, stop_words, Durability::NONE);
+        for (const GeneratedDocument& document : corpus) {
+            durable_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+    }
+    {
+        LatencyRecorder recorder("Recovery/wal"s);
+        std::unique_ptr<DurableSearchServer> durable_server;
+        recorder.Measure([&] { durable_server = std::make_unique<DurableSearchServer>(directory, stop_words, Durability::NONE); });
+        results.push_back(recorder.Finish(corpus.size()));
+        durable_server->Checkpoint();
+    }
+    {
+        LatencyRecorder recorder("Recovery/snapshot"s);
+        std::unique_ptr<DurableSearchServer> durable_server;
+        recorder.Measure([&] { durable_server = std::make_unique<DurableSearchServer>(directory, stop_words, Durability::NONE); });
+        results.push_back(recorder.Finish(corpus.size()));
+    }
+    {
+        LatencyRecorder recorder("Recovery/reindex"s);
+        std::unique_ptr<SearchServer> search_server;
+        recorder.Measure([&] {
+            search_server = std::make_unique<SearchServer>(stop_words);
+            AddCorpus(*search_server, corpus);
+        });
+        results.push_back(recorder.Finish(corpus.size()));
+    }
+    RemoveIndexFiles(directory);
+    return results;
+}
+
+int CheckCrashRecovery(const BenchmarkOptions& options, const std::string& directory, std::ostream& out)
+{
+    std::vector<GeneratedDocument> corpus = GenerateCorpus(options.corpus);
+    corpus.resize(std::min(options.durable_count, corpus.size()));
+    QueryLogOptions query_options = options.queries;
+    query_options.vocabulary_size = options.corpus.vocabulary_size;
+    const std::vector<std::string> queries = GenerateQueries(query_options);
+    const std::string stop_words = GenerateStopWords(options.stop_word_count);
+    RemoveIndexFiles(directory);
+
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+        throw std::runtime_error("Unable to create pipe"s);
+    }
+    const pid_t pid = fork();
+    if (pid < 0) {
+        throw std::runtime_error("Unable to start writer process"s);
+    }
+    if (pid == 0) {
+        close(pipe_fds[0]);
+        RunCrashingWriter(options, directory, corpus, pipe_fds[1]);
+    }
+    close(pipe_fds[1]);
+
+    std::vector<int> acknowledged_ids;
+    int document_id = 0;
+    bool killed = false;
+    while (read(pipe_fds[0], &document_id, sizeof(document_id)) == sizeof(document_id)) {
+        acknowledged_ids.push_back(document_id);
+        if (!killed && acknowledged_ids.size() == corpus.size() / 2) {
+            // Acks already in the pipe are read below; the writer may also have
+            // logged one more document it never got to acknowledge.
+            kill(pid, SIGKILL);
+            killed = true;
+        }
+    }
+    close(pipe_fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    // A torn record: the header promises more bytes than were written.
+    {
+        std::string torn_record;
+        AppendUint32(torn_record, 100);
+        AppendUint32(torn_record, 0);
+        torn_record.append(10, 'x');
+        const int fd = open(DurableSearchServer::GetLogPath(directory).c_str(), O_WRONLY | O_APPEND);
+        if (fd >= 0) {
+            WriteAll(fd, torn_record);
+            close(fd);
+        }
+    }
+
+    int failures = 0;
+    const DurableSearchServer durable_server(directory, stop_words, Durability::NONE);
+    const SearchServer& recovered = durable_server.GetSearchServer();
+    const RecoveryReport& report = durable_server.GetRecoveryReport();
+    const std::set<int> recovered_ids(recovered.begin(), recovered.end());
+    for (int id : acknowledged_ids) {
+        if (recovered_ids.count(id) == 0) {
+            out << "Acknowledged document "s << id << " was lost"s << std::endl;
+            ++failures;
+            break;
+        }
+    }
+    if (recovered_ids.size() > acknowledged_ids.size() + 1) {
+        out << "Recovered "s << recovered_ids.size() << " documents, only "s << acknowledged_ids.size()
+            << " were acknowledged"s << std::endl;
+        ++failures;
+    }
+    if (report.replay.truncated_bytes == 0) {
+        out << "The torn log tail was not truncated"s << std::endl;
+        ++failures;
+    }
+
+    SearchServer reference_server(stop_words);
+    for (const GeneratedDocument& document : corpus) {
+        if (recovered_ids.count(document.id) > 0) {
+            reference_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+    }
+    int ranking_mismatches = 0;
+    for (const std::string& query : queries) {
+        if (!HaveSameRanking(reference_server.FindTopDocuments(query), recovered.FindTopDocuments(query))) {
+            ++ranking_mismatches;
+        }
+    }
+    if (ranking_mismatches > 0) {
+        out << "Recovered index ranks "s << ranking_mismatches << " queries differently"s << std::endl;
+        ++failures;
+    }
+
+    out << "Crash recovery: "s << acknowledged_ids.size() << " acknowledged, "s << recovered_ids.size()
+        << " recovered ("s << report.snapshot_documents << " from snapshot, "s << report.replay.applied_records
+        << " replayed), "s << report.replay.truncated_bytes << " torn bytes truncated, "s
+        << failures << " failures"s << std::endl;
+    RemoveIndexFiles(directory);
+
+    out.flush();
+    const pid_t failing_pid = fork();
+    if (failing_pid < 0) {
+        throw std::runtime_error("Unable to start writer process"s);
+    }
+    if (failing_pid == 0) {
+        RunFailingWriters(options, directory, corpus, out);
+    }
+    int failing_status = 0;
+    waitpid(failing_pid, &failing_status, 0);
+    failures += WIFEXITED(failing_status) ? WEXITSTATUS(failing_status) : 1;
+    RemoveIndexFiles(directory);
+    return failures;
+}
+
+std::ostream& operator<<(std::ostream& out, const BenchmarkResult& result)
+{
+    out << result.name << ": ops = "s << result.operations
+        << ", throughput = "s << static_cast<long long>(result.operations_per_second) << " ops/s"s
+        << ", p50 = "s << result.p50.count() << " ns"s
+        << ", p99 = "s << result.p99.count() << " ns"s
+        << ", p999 = "s << result.p999.count() << " ns"s
+        << ", max = "s << result.max.count() << " ns"s
+        << ", peak_heap = "s << result.peak_heap_kb << " KiB"s;
+    if (METRICS_ENABLED) {
+        out << ", allocs/op = "s << result.allocations_per_operation;
+    }
+    return out;
+}
+
+void WriteBenchmarkResults(std::ostream& out, const std::vector<BenchmarkResult>& results)
+{
+    for (const BenchmarkResult& result : results) {
+        out << result.name << '\t' << result.operations_per_second << '\t' << result.p50.count()
+            << '\t' << result.p99.count() << '\t' << result.p999.count() << '\t' << result.peak_heap_kb << '\n';
+    }
+}
+
+int CompareWithBaseline(std::istream& baseline, const std::vector<BenchmarkResult>& results,
+    const BaselineTolerance& tolerance, std::ostream& out)
+{
+    // Heap growth below this is allocator noise rather than a regression.
+    constexpr double HEAP_NOISE_KB = 1024.0;
+
+    struct BaselineResult {
+        double operations_per_second = 0.0;
+        long long p99 = 0;
+        // Negative for baselines written before heap growth was recorded.
+        double peak_heap_kb = -1.0;
+    };
+    std::map<std::string, BaselineResult> baseline_results;
+    std::string line;
+    while (std::getline(baseline, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        BaselineResult result;
+        long long p50 = 0;
+        long long p999 = 0;
+        if (std::getline(fields, name, '\t') && fields >> result.operations_per_second >> p50 >> result.p99 >> p999) {
+            if (!(fields >> result.peak_heap_kb)) {
+                result.peak_heap_kb = -1.0;
+            }
+            baseline_results[name] = result;
+        }
+    }
+
+    int regressions = 0;
+    for (const BenchmarkResult& result : results) {
+        const auto it = baseline_results.find(result.name);
+        if (it == baseline_results.end()) {
+            continue;
+        }
+        const BaselineResult& expected = it->second;
+        if (expected.operations_per_second > 0.0
+            && result.operations_per_second < expected.operations_per_second * (1.0 - tolerance.throughput)) {
+            out << "REGRESSION "s << result.name << ": "s << static_cast<long long>(result.operations_per_second)
+                << " ops/s vs baseline "s << static_cast<long long>(expected.operations_per_second) << " ops/s"s << std::endl;
+            ++regressions;
+        }
+        if (expected.p99 > 0 && result.p99.count() > expected.p99 * (1.0 + tolerance.p99)) {
+            out << "REGRESSION "s << result.name << ": p99 = "s << result.p99.count()
+                << " ns vs baseline "s << expected.p99 << " ns"s << std::endl;
+            ++regressions;
+        }
+        if (expected.peak_heap_kb >= 0.0
+            && result.peak_heap_kb > expected.peak_heap_kb * (1.0 + tolerance.peak_heap) + HEAP_NOISE_KB) {
+            out << "REGRESSION "s << result.name << ": peak_heap = "s << result.peak_heap_kb
+                << " KiB vs baseline "s << static_cast<long long>(expected.peak_heap_kb) << " KiB"s << std::endl;
+            ++regressions;
+        }
+    }
+    return regressions;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "corpus_generator.h"
+
+struct BenchmarkOptions {
+    CorpusOptions corpus;
+    QueryLogOptions queries;
+    size_t stop_word_count = 10;
+    size_t match_count = 2000;
+    size_t remove_count = 1000;
+    size_t batch_size = 256;
+    size_t durable_count = 2000;
+    size_t writer_threads = 8;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    size_t operations = 0;
+    double operations_per_second = 0.0;
+    std::chrono::nanoseconds p50{ 0 };
+    std::chrono::nanoseconds p99{ 0 };
+    std::chrono::nanoseconds p999{ 0 };
+    std::chrono::nanoseconds max{ 0 };
+    // Peak heap above the level when the case started, sampled between
+    // operations; objects built by the case are kept until it finishes.
+    size_t peak_heap_kb = 0;
+    // Only counted when built with SEARCH_SERVER_METRICS.
+    double allocations_per_operation = 0.0;
+};
+
+std::vector<BenchmarkResult> RunBenchmarks(const BenchmarkOptions& options);
+
+// Compares default FindTopDocuments against the float32 impact index, built in
+// document id order and in MinHash order, on the benchmark corpus: every rank
+// must hold the same document, up to the order of documents tied within
+// MAX_DIFFERENCE, and agree on relevance within MAX_DIFFERENCE. The same holds
+// on a corpus of rare words, whose relevances are large enough for float sums
+// to drift past MAX_DIFFERENCE. The uint16 index must rank the same way, and
+// its raw scores must stay within max_impact / 131070 per query word. Also prints the posting gap statistics of
+// both orders. Returns the number of queries that disagree.
+int CheckImpactRanking(const BenchmarkOptions& options, std::ostream& out);
+
+// Builds a SearchServer and local and process ShardedSearchServers over the
+// benchmark corpus and removes the same documents from each. Every query must
+// rank as in the single server, up to the order of tied documents, and
+// MatchDocument must agree on sampled documents, removed ones included.
+// Returns the number of disagreements.
+int CheckShardedSearch(const BenchmarkOptions& options, std::ostream& out);
+
+// Walks the first results of every benchmark query in pages of several sizes
+// and compares them with the same results fetched as one page, and the first
+// page with sequential and parallel FindTopDocuments, document for document.
+// Then walks
+// documents whose relevances differ by less than MAX_DIFFERENCE but not
+// transitively. Every walk must visit each document once, in order, and end.
+// Returns the number of failed walks.
+int CheckCursorPagination(const BenchmarkOptions& options, std::ostream& out);
+
+// Runs every benchmark query with an unlimited budget, with an expired
+// deadline and with a cancelled token, the last through FindTopDocumentsAsync.
+// Unlimited and untruncated results must match FindTopDocuments; truncated
+// ones may only hold matching documents, at no more than their full
+// relevance. Also cancels a long query mid-flight and times how soon it
+// returns. Returns the number of failed checks.
+int CheckQueryBudget(const BenchmarkOptions& options, std::ostream& out);
+
+// Prints the heap taken by an index of the benchmark corpus for every forward
+// index encoding.
+void PrintIndexMemory(const BenchmarkOptions& options, std::ostream& out);
+
+// Times durable AddDocument from writer_threads threads under each durability
+// level, and reopening the whole corpus from the write-ahead log, from a
+// snapshot and by re-adding every document. Leaves the directory empty.
+std::vector<BenchmarkResult> RunRecoveryBenchmarks(const BenchmarkOptions& options, const std::string& directory);
+
+// Kills a process writing to a DurableSearchServer halfway through, tears the
+// log tail and reopens the index: every acknowledged document must be back and
+// rank as in a server built directly. Then makes the log fail under concurrent
+// writers: exactly the acknowledged documents must remain, live and after
+// reopening. Returns the number of failed checks.
+int CheckCrashRecovery(const BenchmarkOptions& options, const std::string& directory, std::ostream& out);
+
+std::ostream& operator<<(std::ostream& out, const BenchmarkResult& result);
+
+// One tab-separated line per result: name, operations per second, p50, p99 and
+// p999 in nanoseconds, peak heap in KiB.
+void WriteBenchmarkResults(std::ostream& out, const std::vector<BenchmarkResult>& results);
+
+// Allowed relative change against a baseline.
+struct BaselineTolerance {
+    double throughput = 0.1;
+    // Tail latency varies more from run to run than throughput.
+    double p99 = 0.25;
+    double peak_heap = 0.1;
+};
+
+// Prints every benchmark whose throughput dropped, or whose p99 latency or
+// peak heap grew, by more than the tolerance against a file produced by
+// WriteBenchmarkResults, and returns the number of regressions.
+int CompareWithBaseline(std::istream& baseline, const std::vector<BenchmarkResult>& results,
+    const BaselineTolerance& tolerance, std::ostream& out);
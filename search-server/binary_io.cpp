@@ -0,0 +1,234 @@
+#include "binary_io.h"
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std::string_literals;
+
+namespace {
+    std::runtime_error SystemError(const std::string& what) {
+        return std::runtime_error(what + ": "s + std::strerror(errno));
+    }
+
+    std::array<uint32_t, 256> MakeCrc32Table() {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < table.size(); ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            }
+            table[i] = crc;
+        }
+        return table;
+    }
+}
+
+uint32_t ComputeCrc32(std::string_view data)
+{
+    static const std::array<uint32_t, 256> table = MakeCrc32Table();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (char c : data) {
+        crc = table[(crc ^ static_cast<uint8_t>(c)) & 0xFFu] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void AppendUint8(std::string& out, uint8_t value)
+{
+    out.push_back(static_cast<char>(value));
+}
+
+void AppendUint32(std::string& out, uint32_t value)
+{
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFFu));
+    }
+}
+
+void AppendUint64(std::string& out, uint64_t value)
+{
+    for (int shift = 0; shift < 64; shift += 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFFu));
+    }
+}
+
+void AppendDouble(std::string& out, double value)
+{
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    AppendUint64(out, bits);
+}
+
+void AppendString(std::string& out, std::string_view value)
+{
+    AppendUint32(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+BinaryReader::BinaryReader(std::string_view data)
+    : data_(data)
+{
+}
+
+bool BinaryReader::ReadUint8(uint8_t& value)
+{
+    if (data_.size() - offset_ < 1) {
+        return false;
+    }
+    value = static_cast<uint8_t>(data_[offset_++]);
+    return true;
+}
+
+bool BinaryReader::ReadUint32(uint32_t& value)
+{
+    if (data_.size() - offset_ < 4) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<uint8_t>(data_[offset_ + i])) << (8 * i);
+    }
+    offset_ += 4;
+    return true;
+}
+
+bool BinaryReader::ReadUint64(uint64_t& value)
+{
+    if (data_.size() - offset_ < 8) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(data_[offset_ + i])) << (8 * i);
+    }
+    offset_ += 8;
+    return true;
+}
+
+bool BinaryReader::ReadDouble(double& value)
+{
+    uint64_t bits = 0;
+    if (!ReadUint64(bits)) {
+        return false;
+    }
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+bool BinaryReader::ReadString(std::string_view& value)
+{
+    const size_t start = offset_;
+    uint32_t size = 0;
+    if (!ReadUint32(size) || !ReadBytes(size, value)) {
+        offset_ = start;
+        return false;
+    }
+    return true;
+}
+
+bool BinaryReader::ReadBytes(size_t size, std::string_view& value)
+{
+    if (data_.size() - offset_ < size) {
+        return false;
+    }
+    value = data_.substr(offset_, size);
+    offset_ += size;
+    return true;
+}
+
+size_t BinaryReader::GetOffset() const
+{
+    return offset_;
+}
+
+bool BinaryReader::IsEnd() const
+{
+    return offset_ == data_.size();
+}
+
+bool ReadFileContents(const std::string& path, std::string& contents)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return false;
+        }
+        throw SystemError("Unable to open "s + path);
+    }
+    contents.clear();
+    char buffer[1 << 16];
+    while (true) {
+        const ssize_t received = read(fd, buffer, sizeof(buffer));
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0) {
+            close(fd);
+            throw SystemError("Unable to read "s + path);
+        }
+        if (received == 0) {
+            break;
+        }
+        contents.append(buffer, static_cast<size_t>(received));
+    }
+    close(fd);
+    return true;
+}
+
+void WriteFileAtomically(const std::string& path, std::string_view contents)
+{
+    const std::string temporary_path = path + ".tmp"s;
+    const int fd = open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw SystemError("Unable to create "s + temporary_path);
+    }
+    try {
+        WriteAll(fd, contents);
+        if (fsync(fd) != 0) {
+            throw SystemError("Unable to sync "s + temporary_path);
+        }
+    }
+    catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+    if (rename(temporary_path.c_str(), path.c_str()) != 0) {
+        throw SystemError("Unable to rename "s + temporary_path);
+    }
+    SyncParentDirectory(path);
+}
+
+void SyncParentDirectory(const std::string& path)
+{
+    const size_t slash = path.rfind('/');
+    const std::string directory = slash == std::string::npos ? "."s : path.substr(0, slash + 1);
+    const int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        throw SystemError("Unable to open directory "s + directory);
+    }
+    const int result = fsync(fd);
+    close(fd);
+    if (result != 0) {
+        throw SystemError("Unable to sync directory "s + directory);
+    }
+}
+
+void WriteAll(int fd, std::string_view data)
+{
+    while (!data.empty()) {
+        const ssize_t written = write(fd, data.data(), data.size());
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0) {
+            throw SystemError("Unable to write"s);
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Helpers shared by the write-ahead log and index snapshots. Integers are
+// stored little-endian regardless of the host.
+
+// CRC-32 (IEEE 802.3, reflected, as used by zlib).
+uint32_t ComputeCrc32(std::string_view data);
+
+void AppendUint8(std::string& out, uint8_t value);
+void AppendUint32(std::string& out, uint32_t value);
+void AppendUint64(std::string& out, uint64_t value);
+void AppendDouble(std::string& out, double value);
+// Length-prefixed with a uint32.
+void AppendString(std::string& out, std::string_view value);
+
+// Reads values written by the Append* functions. Every Read* returns false
+// and leaves the reader unchanged when the data ends first.
+class BinaryReader {
+public:
+    explicit BinaryReader(std::string_view data);
+
+    bool ReadUint8(uint8_t& value);
+    bool ReadUint32(uint32_t& value);
+    bool ReadUint64(uint64_t& value);
+    bool ReadDouble(double& value);
+    bool ReadString(std::string_view& value);
+    bool ReadBytes(size_t size, std::string_view& value);
+
+    size_t GetOffset() const;
+    bool IsEnd() const;
+
+private:
+    std::string_view data_;
+    size_t offset_ = 0;
+};
+
+// Returns false when the file does not exist; throws on other errors.
+bool ReadFileContents(const std::string& path, std::string& contents);
+
+// Writes to a temporary file, fsyncs it and renames it over path, so readers
+// see either the old or the new contents.
+void WriteFileAtomically(const std::string& path, std::string_view contents);
+
+void WriteAll(int fd, std::string_view data);
+
+// Fsyncs the directory holding path, making a created or renamed file durable.
+void SyncParentDirectory(const std::string& path);
@@ -6,6 +6,9 @@
 #include <iostream>
 #include <iterator>
 #include <list>
+#include <map>
+#include <memory_resource>
+#include <mutex>
 #include <string>
 #include <string_view>
 #include <type_traits>
@@ -17,9 +20,45 @@ using namespace std::string_literals;
 template <typename Key, typename Value>
 class ConcurrentMap {
 private:
+    // Serializes the buckets' requests to an upstream resource that need not
+    // be thread-safe. Buckets only come here when their own buffer runs out.
+    class SynchronizedResource : public std::pmr::memory_resource {
+    public:
+        explicit SynchronizedResource(std::pmr::memory_resource* upstream)
+            : upstream_(upstream) {
+        }
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            std::lock_guard guard(mutex_);
+            return upstream_->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override {
+            std::lock_guard guard(mutex_);
+            upstream_->deallocate(pointer, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        std::mutex mutex_;
+        std::pmr::memory_resource* upstream_;
+    };
+
+    // Each bucket grows its own monotonic buffer, so inserts into different
+    // buckets do not contend; erased entries are not reused until destruction.
     struct Bucket {
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        explicit Bucket(const allocator_type& allocator)
+            : resource(allocator.resource()) {
+        }
+
         std::mutex mutex;
-        std::map<Key, Value> map;
+        std::pmr::monotonic_buffer_resource resource;
+        std::pmr::map<Key, Value> map{ &resource };
     };
 
 public:
@@ -36,7 +75,13 @@ public:
     };
 
     explicit ConcurrentMap(size_t bucket_count)
-        : buckets_(bucket_count) {
+        : ConcurrentMap(bucket_count, std::pmr::get_default_resource()) {
+    }
+
+    // All memory, buckets included, comes from the resource.
+    ConcurrentMap(size_t bucket_count, std::pmr::memory_resource* resource)
+        : upstream_(resource)
+        , buckets_(bucket_count, &upstream_) {
     }
 
     Access operator[](const Key& key) {
@@ -46,9 +91,18 @@ public:
 
     std::map<Key, Value> BuildOrdinaryMap() {
         std::map<Key, Value> result;
-        for (auto& [mutex, map] : buckets_) {
-            std::lock_guard g(mutex);
-            result.insert(map.begin(), map.end());
+        for (auto& bucket : buckets_) {
+            std::lock_guard g(bucket.mutex);
+            result.insert(bucket.map.begin(), bucket.map.end());
+        }
+        return result;
+    }
+
+    std::pmr::map<Key, Value> BuildOrdinaryMap(std::pmr::memory_resource* resource) {
+        std::pmr::map<Key, Value> result(resource);
+        for (auto& bucket : buckets_) {
+            std::lock_guard g(bucket.mutex);
+            result.insert(bucket.map.begin(), bucket.map.end());
         }
         return result;
     }
@@ -60,5 +114,6 @@ public:
     }
 
 private:
-    std::vector<Bucket> buckets_;
+    SynchronizedResource upstream_;
+    std::pmr::vector<Bucket> buckets_;
 };
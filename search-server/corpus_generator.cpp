@@ -0,0 +1,130 @@
+#include "corpus_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace {
+
+    double NextUnit(std::mt19937& generator) {
+        return (generator() + 0.5) / 4294967296.0;
+    }
+
+    size_t NextIndex(std::mt19937& generator, size_t size) {
+        return static_cast<size_t>(NextUnit(generator) * size);
+    }
+
+    size_t NextInRange(std::mt19937& generator, size_t min_value, size_t max_value) {
+        return min_value + NextIndex(generator, max_value - min_value + 1);
+    }
+
+}
+
+ZipfDistribution::ZipfDistribution(size_t size, double exponent)
+    : cumulative_(size)
+{
+    if (size == 0) {
+        throw std::invalid_argument("Zipf distribution needs a non-empty range"s);
+    }
+    double total = 0.0;
+    for (size_t rank = 0; rank < size; ++rank) {
+        total += 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+        cumulative_[rank] = total;
+    }
+    for (double& value : cumulative_) {
+        value /= total;
+    }
+}
+
+size_t ZipfDistribution::operator()(std::mt19937& generator) const
+{
+    const auto it = std::lower_bound(cumulative_.begin(), cumulative_.end(), NextUnit(generator));
+    return std::min(static_cast<size_t>(it - cumulative_.begin()), cumulative_.size() - 1);
+}
+
+std::string GetCorpusWord(size_t rank)
+{
+    return "w"s + std::to_string(rank);
+}
+
+std::string GenerateStopWords(size_t count)
+{
+    std::string stop_words;
+    for (size_t rank = 0; rank < count; ++rank) {
+        if (rank > 0) {
+            stop_words += ' ';
+        }
+        stop_words += GetCorpusWord(rank);
+    }
+    return stop_words;
+}
+
+std::vector<GeneratedDocument> GenerateCorpus(const CorpusOptions& options)
+{
+    std::mt19937 generator(options.seed);
+    const ZipfDistribution word_distribution(options.vocabulary_size, options.zipf_exponent);
+
+    std::vector<GeneratedDocument> documents;
+    std::vector<std::vector<size_t>> document_words;
+    documents.reserve(options.document_count);
+    document_words.reserve(options.document_count);
+
+    for (size_t i = 0; i < options.document_count; ++i) {
+        std::vector<size_t> words;
+        if (!document_words.empty() && NextUnit(generator) < options.duplicate_fraction) {
+            words = document_words[NextIndex(generator, document_words.size())];
+            std::reverse(words.begin(), words.end());
+        }
+        else {
+            words.resize(NextInRange(generator, options.min_words, options.max_words));
+            for (size_t& word : words) {
+                word = word_distribution(generator);
+            }
+        }
+
+        GeneratedDocument document;
+        document.id = static_cast<int>(i);
+        for (size_t word : words) {
+            if (!document.text.empty()) {
+                document.text += ' ';
+            }
+            document.text += GetCorpusWord(word);
+        }
+        const size_t status_roll = NextIndex(generator, 20);
+        document.status = status_roll == 0 ? DocumentStatus::BANNED
+            : status_roll == 1 ? DocumentStatus::IRRELEVANT
+            : DocumentStatus::ACTUAL;
+        for (size_t j = NextInRange(generator, 0, 5); j > 0; --j) {
+            document.ratings.push_back(static_cast<int>(NextInRange(generator, 0, 20)) - 10);
+        }
+
+        documents.push_back(std::move(document));
+        document_words.push_back(std::move(words));
+    }
+    return documents;
+}
+
+std::vector<std::string> GenerateQueries(const QueryLogOptions& options)
+{
+    std::mt19937 generator(options.seed);
+    const ZipfDistribution word_distribution(options.vocabulary_size, options.zipf_exponent);
+
+    std::vector<std::string> queries;
+    queries.reserve(options.query_count);
+    for (size_t i = 0; i < options.query_count; ++i) {
+        std::string query;
+        for (size_t j = NextInRange(generator, options.min_words, options.max_words); j > 0; --j) {
+            if (!query.empty()) {
+                query += ' ';
+            }
+            if (NextUnit(generator) < options.minus_word_probability) {
+                query += '-';
+            }
+            query += GetCorpusWord(word_distribution(generator));
+        }
+        queries.push_back(std::move(query));
+    }
+    return queries;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "document.h"
+
+// Every draw goes through std::mt19937 directly instead of the standard
+// distributions, whose algorithms differ between library implementations,
+// so the same seed yields the same corpus everywhere.
+class ZipfDistribution {
+public:
+    ZipfDistribution(size_t size, double exponent);
+
+    size_t operator()(std::mt19937& generator) const;
+
+private:
+    std::vector<double> cumulative_;
+};
+
+struct CorpusOptions {
+    size_t document_count = 10000;
+    size_t vocabulary_size = 20000;
+    size_t min_words = 5;
+    size_t max_words = 50;
+    double zipf_exponent = 1.0;
+    // Share of documents that repeat the words of an earlier document in another order.
+    double duplicate_fraction = 0.01;
+    uint32_t seed = 42;
+};
+
+struct QueryLogOptions {
+    size_t query_count = 1000;
+    size_t vocabulary_size = 20000;
+    size_t min_words = 1;
+    size_t max_words = 5;
+    double zipf_exponent = 1.0;
+    double minus_word_probability = 0.1;
+    uint32_t seed = 4242;
+};
+
+struct GeneratedDocument {
+    int id = 0;
+    std::string text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
+
+std::string GetCorpusWord(size_t rank);
+
+// The most frequent words of the vocabulary, separated by spaces.
+std::string GenerateStopWords(size_t count);
+
+std::vector<GeneratedDocument> GenerateCorpus(const CorpusOptions& options);
+
+std::vector<std::string> GenerateQueries(const QueryLogOptions& options);
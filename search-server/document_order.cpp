@@ -0,0 +1,57 @@
+#include "document_order.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+
+namespace {
+    uint64_t HashWord(std::string_view word) {
+        // FNV-1a, so the order does not depend on the standard library.
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : word) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t MixHash(uint64_t hash, uint64_t seed) {
+        // splitmix64 finalizer.
+        hash += seed * 0x9e3779b97f4a7c15ull;
+        hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+        hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+        return hash ^ (hash >> 31);
+    }
+}
+
+std::vector<int> ComputeMinHashOrder(const SearchServer& search_server, size_t hash_count)
+{
+    std::vector<int> document_ids(search_server.begin(), search_server.end());
+    std::vector<std::vector<uint64_t>> signatures(document_ids.size(),
+        std::vector<uint64_t>(hash_count, std::numeric_limits<uint64_t>::max()));
+
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        for (const auto& [word, _] : search_server.GetWordFrequencies(document_ids[i])) {
+            const uint64_t word_hash = HashWord(word);
+            for (size_t seed = 0; seed < hash_count; ++seed) {
+                signatures[i][seed] = std::min(signatures[i][seed], MixHash(word_hash, seed));
+            }
+        }
+    }
+
+    std::vector<size_t> positions(document_ids.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        positions[i] = i;
+    }
+    // document_ids is sorted, so comparing positions breaks ties by id.
+    std::sort(positions.begin(), positions.end(), [&signatures](size_t lhs, size_t rhs) {
+        return std::tie(signatures[lhs], lhs) < std::tie(signatures[rhs], rhs);
+    });
+
+    std::vector<int> order;
+    order.reserve(positions.size());
+    for (size_t position : positions) {
+        order.push_back(document_ids[position]);
+    }
+    return order;
+}
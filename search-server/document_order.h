@@ -0,0 +1,11 @@
+#pragma once
+
+#include <vector>
+
+#include "search_server.h"
+
+// Orders documents so that ones sharing words end up next to each other: each
+// document gets a MinHash signature over its words and documents are sorted by
+// signature, then by id. Pass the result to SearchServer::BuildImpactIndex to
+// get denser posting lists (smaller ordinal gaps) and better score locality.
+std::vector<int> ComputeMinHashOrder(const SearchServer& search_server, size_t hash_count = 4);
@@ -0,0 +1,169 @@
+#include "durable_search_server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+#include <sys/stat.h>
+
+#include "index_snapshot.h"
+
+using namespace std::string_literals;
+
+DurableSearchServer::DurableSearchServer(const std::string& directory, std::string_view stop_words_text,
+    Durability durability)
+    : directory_(directory)
+{
+    const auto start = std::chrono::steady_clock::now();
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Unable to create "s + directory + ": "s + std::strerror(errno));
+    }
+
+    IndexSnapshot snapshot = LoadSnapshot(GetSnapshotPath(directory));
+    if (snapshot.search_server == nullptr) {
+        // Saved right away so that replay never depends on the stop words
+        // passed to a later Open.
+        snapshot.search_server = std::make_unique<SearchServer>(stop_words_text);
+        SaveSnapshot(*snapshot.search_server, 0, GetSnapshotPath(directory));
+    }
+    search_server_ = std::move(snapshot.search_server);
+    recovery_report_.snapshot_documents = static_cast<size_t>(search_server_->GetDocumentCount());
+    recovery_report_.snapshot_lsn = snapshot.lsn;
+
+    recovery_report_.replay = ReplayWriteAheadLog(GetLogPath(directory), snapshot.lsn, [this](const WalRecord& record) {
+        if (record.type == WalRecordType::ADD_DOCUMENT) {
+            search_server_->AddDocument(record.document_id, record.text, record.status, record.ratings);
+        }
+        else {
+            search_server_->RemoveDocument(record.document_id);
+        }
+    });
+
+    log_ = std::make_unique<WriteAheadLog>(GetLogPath(directory), durability, recovery_report_.replay.last_lsn);
+    recovery_report_.duration = std::chrono::steady_clock::now() - start;
+}
+
+void DurableSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+    const std::vector<int>& ratings)
+{
+    uint64_t lsn = 0;
+    {
+        // Applied first so that invalid documents throw before they are logged.
+        std::lock_guard lock(mutex_);
+        search_server_->AddDocument(document_id, document, status, ratings);
+        try {
+            lsn = log_->AppendAddDocument(document_id, document, status, ratings);
+        }
+        catch (...) {
+            search_server_->RemoveDocument(document_id);
+            RollBackUnlogged();
+            throw;
+        }
+        if (log_->GetDurability() == Durability::GROUP) {
+            unlogged_.emplace(lsn, UnloggedMutation{ WalRecordType::ADD_DOCUMENT, document_id, {} });
+        }
+    }
+    WaitDurable(lsn);
+}
+
+void DurableSearchServer::RemoveDocument(int document_id)
+{
+    uint64_t lsn = 0;
+    {
+        std::lock_guard lock(mutex_);
+        if (search_server_->documents_.count(document_id) == 0) {
+            return;
+        }
+        SearchServer::StoredDocument removed = search_server_->GetStoredDocument(document_id);
+        search_server_->RemoveDocument(document_id);
+        try {
+            lsn = log_->AppendRemoveDocument(document_id);
+        }
+        catch (...) {
+            search_server_->RestoreStoredDocument(removed);
+            RollBackUnlogged();
+            throw;
+        }
+        if (log_->GetDurability() == Durability::GROUP) {
+            unlogged_.emplace(lsn, UnloggedMutation{ WalRecordType::REMOVE_DOCUMENT, document_id, std::move(removed) });
+        }
+    }
+    WaitDurable(lsn);
+}
+
+void DurableSearchServer::Checkpoint()
+{
+    std::lock_guard lock(mutex_);
+    // Makes every applied mutation durable first, so that a failed log is
+    // noticed and rolled back before the snapshot could persist it.
+    try {
+        log_->Sync();
+    }
+    catch (...) {
+        RollBackUnlogged();
+        throw;
+    }
+    unlogged_.clear();
+    // A crash between these two steps leaves records the snapshot already
+    // covers; replay skips them by LSN.
+    SaveSnapshot(*search_server_, log_->GetLastLsn(), GetSnapshotPath(directory_));
+    log_->Reset();
+}
+
+void DurableSearchServer::WaitDurable(uint64_t lsn)
+{
+    if (log_->GetDurability() != Durability::GROUP) {
+        return;
+    }
+    try {
+        log_->WaitDurable(lsn);
+    }
+    catch (...) {
+        std::lock_guard lock(mutex_);
+        RollBackUnlogged();
+        throw;
+    }
+    std::lock_guard lock(mutex_);
+    unlogged_.erase(lsn);
+}
+
+void DurableSearchServer::RollBackUnlogged()
+{
+    const uint64_t durable_lsn = log_->GetDurableLsn();
+    while (!unlogged_.empty() && unlogged_.rbegin()->first > durable_lsn) {
+        const auto newest = std::prev(unlogged_.end());
+        if (newest->second.type == WalRecordType::ADD_DOCUMENT) {
+            search_server_->RemoveDocument(newest->second.document_id);
+        }
+        else {
+            search_server_->RestoreStoredDocument(newest->second.removed);
+        }
+        unlogged_.erase(newest);
+    }
+}
+
+const SearchServer& DurableSearchServer::GetSearchServer() const
+{
+    return *search_server_;
+}
+
+const RecoveryReport& DurableSearchServer::GetRecoveryReport() const
+{
+    return recovery_report_;
+}
+
+const WriteAheadLog& DurableSearchServer::GetWriteAheadLog() const
+{
+    return *log_;
+}
+
+std::string DurableSearchServer::GetSnapshotPath(const std::string& directory)
+{
+    return directory + "/snapshot"s;
+}
+
+std::string DurableSearchServer::GetLogPath(const std::string& directory)
+{
+    return directory + "/wal"s;
+}
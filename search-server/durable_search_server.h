@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+#include "write_ahead_log.h"
+
+struct RecoveryReport {
+    size_t snapshot_documents = 0;
+    uint64_t snapshot_lsn = 0;
+    WalReplayResult replay;
+    std::chrono::nanoseconds duration{ 0 };
+};
+
+// A SearchServer whose mutations survive a crash. The directory holds a
+// snapshot of the index and a write-ahead log of every mutation since it.
+// Opening loads the snapshot and replays the log on top; Checkpoint writes a
+// new snapshot and empties the log.
+//
+// Mutations may come from several threads at once; they are applied one at a
+// time, and under GROUP durability their fsyncs are shared. Queries through
+// GetSearchServer must not run concurrently with mutations.
+//
+// If the log fails, every mutation that did not become durable is undone in
+// reverse order and its caller gets the error; later mutations and
+// Checkpoint throw it too. Reopen the directory to continue.
+class DurableSearchServer {
+public:
+    // stop_words_text only applies when the directory holds no index yet;
+    // otherwise the snapshot's stop words are used.
+    DurableSearchServer(const std::string& directory, std::string_view stop_words_text,
+        Durability durability = Durability::GROUP);
+
+    DurableSearchServer(const DurableSearchServer&) = delete;
+    DurableSearchServer& operator=(const DurableSearchServer&) = delete;
+
+    // Returns once the mutation is logged with the configured durability.
+    // Invalid documents throw before anything is logged.
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings);
+
+    void RemoveDocument(int document_id);
+
+    void Checkpoint();
+
+    const SearchServer& GetSearchServer() const;
+
+    const RecoveryReport& GetRecoveryReport() const;
+
+    const WriteAheadLog& GetWriteAheadLog() const;
+
+    static std::string GetSnapshotPath(const std::string& directory);
+
+    static std::string GetLogPath(const std::string& directory);
+
+private:
+    std::string directory_;
+    std::unique_ptr<SearchServer> search_server_;
+    std::unique_ptr<WriteAheadLog> log_;
+    RecoveryReport recovery_report_;
+    std::mutex mutex_;
+
+    struct UnloggedMutation {
+        WalRecordType type = WalRecordType::ADD_DOCUMENT;
+        int document_id = 0;
+        // Only set for REMOVE_DOCUMENT.
+        SearchServer::StoredDocument removed;
+    };
+    // GROUP mutations applied to the index but possibly not yet durable, by LSN.
+    std::map<uint64_t, UnloggedMutation> unlogged_;
+
+    void WaitDurable(uint64_t lsn);
+
+    // Undoes, newest first, every unlogged mutation above the durable LSN.
+    // Requires mutex_.
+    void RollBackUnlogged();
+};
@@ -0,0 +1,166 @@
+#include "forward_index.h"
+
+#include <cstring>
+
+namespace {
+    void AppendVarint(std::pmr::vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    uint32_t ReadVarint(const uint8_t*& position) {
+        uint32_t value = 0;
+        for (int shift = 0;; shift += 7) {
+            const uint8_t byte = *position++;
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+    }
+
+    void AppendFixed(std::pmr::vector<uint8_t>& out, uint32_t value) {
+        uint8_t bytes[sizeof(value)];
+        std::memcpy(bytes, &value, sizeof(value));
+        out.insert(out.end(), bytes, bytes + sizeof(value));
+    }
+
+    uint32_t ReadFixed(const uint8_t*& position) {
+        uint32_t value = 0;
+        std::memcpy(&value, position, sizeof(value));
+        position += sizeof(value);
+        return value;
+    }
+
+    // Summed the way AddDocument sums it, so the result matches bit for bit.
+    double ComputeTermFreq(uint32_t count, double inv_word_count) {
+        double term_freq = 0.0;
+        for (uint32_t i = 0; i < count; ++i) {
+            term_freq += inv_word_count;
+        }
+        return term_freq;
+    }
+}
+
+void EncodeTermCounts(ForwardIndexEncoding encoding, const std::vector<std::pair<uint32_t, uint32_t>>& term_counts,
+    std::pmr::vector<uint8_t>& out)
+{
+    if (encoding == ForwardIndexEncoding::DISABLED) {
+        std::pmr::vector<uint8_t>(out.get_allocator()).swap(out);
+        return;
+    }
+    out.clear();
+    if (encoding == ForwardIndexEncoding::PLAIN) {
+        out.reserve(term_counts.size() * 2 * sizeof(uint32_t));
+        for (const auto& [term_id, count] : term_counts) {
+            AppendFixed(out, term_id);
+            AppendFixed(out, count);
+        }
+        return;
+    }
+    uint32_t previous_term_id = 0;
+    for (const auto& [term_id, count] : term_counts) {
+        AppendVarint(out, term_id - previous_term_id);
+        AppendVarint(out, count);
+        previous_term_id = term_id;
+    }
+    out.shrink_to_fit();
+}
+
+TermCountReader::TermCountReader(ForwardIndexEncoding encoding, const uint8_t* begin, const uint8_t* end)
+    : encoding_(encoding)
+    , position_(begin)
+    , end_(end)
+{
+}
+
+bool TermCountReader::Next(uint32_t& term_id, uint32_t& count)
+{
+    if (position_ == end_) {
+        return false;
+    }
+    if (encoding_ == ForwardIndexEncoding::VARINT) {
+        term_id_ += ReadVarint(position_);
+        count = ReadVarint(position_);
+    }
+    else {
+        term_id_ = ReadFixed(position_);
+        count = ReadFixed(position_);
+    }
+    term_id = term_id_;
+    return true;
+}
+
+WordFrequencies::Iterator::Iterator(const WordFrequencies* view, TermCountReader reader)
+    : view_(view)
+    , reader_(reader)
+{
+    ++*this;
+}
+
+WordFrequencies::Iterator::reference WordFrequencies::Iterator::operator*() const
+{
+    return current_;
+}
+
+WordFrequencies::Iterator::pointer WordFrequencies::Iterator::operator->() const
+{
+    return &current_;
+}
+
+WordFrequencies::Iterator& WordFrequencies::Iterator::operator++()
+{
+    uint32_t term_id = 0;
+    uint32_t count = 0;
+    if (reader_.Next(term_id, count)) {
+        current_ = { (*view_->term_words_)[term_id], ComputeTermFreq(count, view_->inv_word_count_) };
+    }
+    else {
+        view_ = nullptr;
+    }
+    return *this;
+}
+
+bool WordFrequencies::Iterator::operator==(const Iterator& other) const
+{
+    // Only an exhausted iterator is compared against, so the view suffices.
+    return view_ == other.view_;
+}
+
+bool WordFrequencies::Iterator::operator!=(const Iterator& other) const
+{
+    return !(*this == other);
+}
+
+WordFrequencies::WordFrequencies(ForwardIndexEncoding encoding, const uint8_t* begin, const uint8_t* end,
+    uint32_t word_count, const std::pmr::vector<std::string_view>* term_words,
+    std::shared_ptr<const std::pmr::vector<uint8_t>> owned)
+    : encoding_(encoding)
+    , begin_(begin)
+    , end_(end)
+    , inv_word_count_(1.0 / word_count)
+    , term_words_(term_words)
+    , owned_(std::move(owned))
+{
+}
+
+WordFrequencies::Iterator WordFrequencies::begin() const
+{
+    if (begin_ == end_) {
+        return end();
+    }
+    return Iterator(this, TermCountReader(encoding_, begin_, end_));
+}
+
+WordFrequencies::Iterator WordFrequencies::end() const
+{
+    return Iterator();
+}
+
+bool WordFrequencies::empty() const
+{
+    return begin_ == end_;
+}
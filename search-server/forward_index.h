@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+enum class ForwardIndexEncoding {
+    // No forward index: RemoveDocument and GetWordFrequencies scan the
+    // inverted index instead.
+    DISABLED,
+    // 4-byte term id and 4-byte occurrence count per word.
+    PLAIN,
+    // Term id deltas and counts as LEB128 varints.
+    VARINT,
+};
+
+// term_counts must be sorted by term id without repeats.
+void EncodeTermCounts(ForwardIndexEncoding encoding, const std::vector<std::pair<uint32_t, uint32_t>>& term_counts,
+    std::pmr::vector<uint8_t>& out);
+
+// Decodes what EncodeTermCounts wrote, one (term id, count) pair at a time.
+class TermCountReader {
+public:
+    TermCountReader() = default;
+    TermCountReader(ForwardIndexEncoding encoding, const uint8_t* begin, const uint8_t* end);
+
+    // Returns false at the end.
+    bool Next(uint32_t& term_id, uint32_t& count);
+
+private:
+    ForwardIndexEncoding encoding_ = ForwardIndexEncoding::PLAIN;
+    const uint8_t* position_ = nullptr;
+    const uint8_t* end_ = nullptr;
+    uint32_t term_id_ = 0;
+};
+
+// A document's words with their term frequencies, decoded from the forward
+// index while iterating, in term id order. Valid until the document is removed,
+// the forward index is re-encoded by SetForwardIndexEncoding or the server is
+// destroyed.
+class WordFrequencies {
+public:
+    using value_type = std::pair<std::string_view, double>;
+
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = WordFrequencies::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        Iterator() = default;
+
+        reference operator*() const;
+        pointer operator->() const;
+        Iterator& operator++();
+        bool operator==(const Iterator& other) const;
+        bool operator!=(const Iterator& other) const;
+
+    private:
+        friend class WordFrequencies;
+
+        Iterator(const WordFrequencies* view, TermCountReader reader);
+
+        const WordFrequencies* view_ = nullptr;
+        TermCountReader reader_;
+        value_type current_;
+    };
+
+    WordFrequencies() = default;
+
+    // word_count is the number of words in the document, repeats included;
+    // term_words maps term ids to words. owned keeps a decoded copy alive when
+    // the view does not point into the index.
+    WordFrequencies(ForwardIndexEncoding encoding, const uint8_t* begin, const uint8_t* end, uint32_t word_count,
+        const std::pmr::vector<std::string_view>* term_words, std::shared_ptr<const std::pmr::vector<uint8_t>> owned = nullptr);
+
+    Iterator begin() const;
+    Iterator end() const;
+
+    bool empty() const;
+
+private:
+    ForwardIndexEncoding encoding_ = ForwardIndexEncoding::PLAIN;
+    const uint8_t* begin_ = nullptr;
+    const uint8_t* end_ = nullptr;
+    double inv_word_count_ = 0.0;
+    const std::pmr::vector<std::string_view>* term_words_ = nullptr;
+    std::shared_ptr<const std::pmr::vector<uint8_t>> owned_;
+};
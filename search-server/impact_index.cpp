@@ -0,0 +1,112 @@
+#include "impact_index.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "impact_kernels.h"
+
+ImpactIndex::ImpactIndex(ImpactEncoding encoding)
+    : encoding_(encoding)
+{
+}
+
+ImpactEncoding ImpactIndex::GetEncoding() const
+{
+    return encoding_;
+}
+
+void ImpactIndex::AddPostings(std::string_view word, const std::vector<std::pair<uint32_t, double>>& ordinal_impacts)
+{
+    std::vector<std::pair<uint32_t, double>> sorted_impacts = ordinal_impacts;
+    std::sort(sorted_impacts.begin(), sorted_impacts.end());
+
+    ImpactPostings& postings = postings_[word];
+    postings.ordinals.reserve(sorted_impacts.size());
+    for (const auto& [ordinal, _] : sorted_impacts) {
+        postings.ordinals.push_back(ordinal);
+    }
+
+    for (const auto& [_, impact] : sorted_impacts) {
+        postings.max_impact = std::max(postings.max_impact, impact);
+    }
+
+    if (encoding_ == ImpactEncoding::FLOAT32) {
+        postings.impacts.reserve(sorted_impacts.size());
+        for (const auto& [_, impact] : sorted_impacts) {
+            postings.impacts.push_back(static_cast<float>(impact));
+        }
+        return;
+    }
+
+    const double max_impact = postings.max_impact;
+    postings.scale = static_cast<float>(max_impact / UINT16_MAX);
+    postings.quantized_impacts.reserve(sorted_impacts.size());
+    for (const auto& [_, impact] : sorted_impacts) {
+        postings.quantized_impacts.push_back(max_impact > 0.0
+            ? static_cast<uint16_t>(std::lround(impact / max_impact * UINT16_MAX))
+            : uint16_t{ 0 });
+    }
+}
+
+const ImpactPostings* ImpactIndex::FindPostings(std::string_view word) const
+{
+    const auto it = postings_.find(word);
+    return it == postings_.end() ? nullptr : &it->second;
+}
+
+void ImpactIndex::Accumulate(const ImpactPostings& postings, float* scores) const
+{
+    if (encoding_ == ImpactEncoding::FLOAT32) {
+        AccumulateImpacts(postings.ordinals.data(), postings.impacts.data(), postings.ordinals.size(), scores);
+    }
+    else {
+        AccumulateQuantizedImpacts(postings.ordinals.data(), postings.quantized_impacts.data(), postings.scale,
+            postings.ordinals.size(), scores);
+    }
+}
+
+double ImpactIndex::GetImpactError(const ImpactPostings& postings) const
+{
+    // Rounding to float, plus for UINT16 half a quantization step and the
+    // float scale and product.
+    const double rounding = postings.max_impact * FLT_EPSILON;
+    if (encoding_ == ImpactEncoding::FLOAT32) {
+        return rounding;
+    }
+    return postings.max_impact / (2.0 * UINT16_MAX) + 2.0 * rounding;
+}
+
+size_t ImpactIndex::GetMemoryUsage() const
+{
+    size_t bytes = 0;
+    for (const auto& [_, postings] : postings_) {
+        bytes += sizeof(ImpactPostings) + postings.ordinals.capacity() * sizeof(uint32_t)
+            + postings.impacts.capacity() * sizeof(float) + postings.quantized_impacts.capacity() * sizeof(uint16_t);
+    }
+    return bytes;
+}
+
+PostingGapStatistics ImpactIndex::GetGapStatistics() const
+{
+    PostingGapStatistics statistics;
+    double log2_gap_sum = 0.0;
+    for (const auto& [_, postings] : postings_) {
+        // The first gap is counted from -1 so that it is never zero.
+        int64_t previous = -1;
+        for (uint32_t ordinal : postings.ordinals) {
+            uint64_t gap = static_cast<uint64_t>(ordinal - previous);
+            previous = ordinal;
+            log2_gap_sum += std::log2(static_cast<double>(gap));
+            do {
+                ++statistics.varint_bytes;
+                gap >>= 7;
+            } while (gap != 0);
+            ++statistics.postings;
+        }
+    }
+    if (statistics.postings > 0) {
+        statistics.average_log2_gap = log2_gap_sum / statistics.postings;
+    }
+    return statistics;
+}
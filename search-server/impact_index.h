@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string_view>
+#include <vector>
+
+enum class ImpactEncoding {
+    FLOAT32,
+    // Per-word linear quantization to 16 bits; scores drift by up to
+    // max_impact / 131070 per word.
+    UINT16,
+};
+
+struct ImpactPostings {
+    std::vector<uint32_t> ordinals;
+    std::vector<float> impacts;
+    std::vector<uint16_t> quantized_impacts;
+    float scale = 0.0f;
+    double max_impact = 0.0;
+};
+
+struct PostingGapStatistics {
+    size_t postings = 0;
+    // Bytes the ordinals would take as delta-encoded varints.
+    size_t varint_bytes = 0;
+    double average_log2_gap = 0.0;
+};
+
+// Posting lists holding precomputed tf-idf impacts keyed by dense document
+// ordinals, accumulated into a score array indexed by ordinal.
+class ImpactIndex {
+public:
+    explicit ImpactIndex(ImpactEncoding encoding);
+
+    ImpactEncoding GetEncoding() const;
+
+    // The word must outlive the index. Postings are stored in ordinal order.
+    void AddPostings(std::string_view word, const std::vector<std::pair<uint32_t, double>>& ordinal_impacts);
+
+    const ImpactPostings* FindPostings(std::string_view word) const;
+
+    void Accumulate(const ImpactPostings& postings, float* scores) const;
+
+    // Bound on how far one accumulated impact of the postings may be from its
+    // double value, before the rounding of the float sum itself.
+    double GetImpactError(const ImpactPostings& postings) const;
+
+    size_t GetMemoryUsage() const;
+
+    PostingGapStatistics GetGapStatistics() const;
+
+private:
+    ImpactEncoding encoding_;
+    std::map<std::string_view, ImpactPostings, std::less<>> postings_;
+};
@@ -0,0 +1,98 @@
+#include "impact_kernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IMPACT_KERNELS_AVX2
+#include <immintrin.h>
+#endif
+
+namespace {
+
+    void AccumulateImpactsScalar(const uint32_t* ordinals, const float* impacts, size_t count, float* scores) {
+        for (size_t i = 0; i < count; ++i) {
+            scores[ordinals[i]] += impacts[i];
+        }
+    }
+
+    void AccumulateQuantizedImpactsScalar(const uint32_t* ordinals, const uint16_t* impacts, float scale, size_t count, float* scores) {
+        for (size_t i = 0; i < count; ++i) {
+            scores[ordinals[i]] += impacts[i] * scale;
+        }
+    }
+
+#ifdef IMPACT_KERNELS_AVX2
+
+    // AVX2 has a gather but no scatter, so sums go back through a small buffer.
+    __attribute__((target("avx2")))
+    void AccumulateImpactsAvx2(const uint32_t* ordinals, const float* impacts, size_t count, float* scores) {
+        alignas(32) float sums[8];
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ordinals + i));
+            const __m256 current = _mm256_i32gather_ps(scores, index, 4);
+            _mm256_store_ps(sums, _mm256_add_ps(current, _mm256_loadu_ps(impacts + i)));
+            for (size_t j = 0; j < 8; ++j) {
+                scores[ordinals[i + j]] = sums[j];
+            }
+        }
+        AccumulateImpactsScalar(ordinals + i, impacts + i, count - i, scores);
+    }
+
+    __attribute__((target("avx2")))
+    void AccumulateQuantizedImpactsAvx2(const uint32_t* ordinals, const uint16_t* impacts, float scale, size_t count, float* scores) {
+        alignas(32) float sums[8];
+        const __m256 scale_vector = _mm256_set1_ps(scale);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ordinals + i));
+            const __m128i quantized = _mm_loadu_si128(reinterpret_cast<const __m128i*>(impacts + i));
+            const __m256 decoded = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(quantized)), scale_vector);
+            const __m256 current = _mm256_i32gather_ps(scores, index, 4);
+            _mm256_store_ps(sums, _mm256_add_ps(current, decoded));
+            for (size_t j = 0; j < 8; ++j) {
+                scores[ordinals[i + j]] = sums[j];
+            }
+        }
+        AccumulateQuantizedImpactsScalar(ordinals + i, impacts + i, scale, count - i, scores);
+    }
+
+    bool HasAvx2() {
+        static const bool has_avx2 = __builtin_cpu_supports("avx2");
+        return has_avx2;
+    }
+
+#else
+
+    bool HasAvx2() {
+        return false;
+    }
+
+#endif
+
+}
+
+void AccumulateImpacts(const uint32_t* ordinals, const float* impacts, size_t count, float* scores)
+{
+#ifdef IMPACT_KERNELS_AVX2
+    if (HasAvx2()) {
+        AccumulateImpactsAvx2(ordinals, impacts, count, scores);
+        return;
+    }
+#endif
+    AccumulateImpactsScalar(ordinals, impacts, count, scores);
+}
+
+void AccumulateQuantizedImpacts(const uint32_t* ordinals, const uint16_t* impacts, float scale, size_t count, float* scores)
+{
+#ifdef IMPACT_KERNELS_AVX2
+    if (HasAvx2()) {
+        AccumulateQuantizedImpactsAvx2(ordinals, impacts, scale, count, scores);
+        return;
+    }
+#endif
+    AccumulateQuantizedImpactsScalar(ordinals, impacts, scale, count, scores);
+}
+
+std::string_view GetImpactKernelName()
+{
+    return HasAvx2() ? "avx2" : "scalar";
+}
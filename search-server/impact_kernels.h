@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// scores[ordinals[i]] += impacts[i]. Ordinals within one call must be distinct,
+// which holds for a posting list. The implementation is picked once at startup:
+// AVX2 (gather, add, scalar store) when the CPU has it, scalar otherwise.
+void AccumulateImpacts(const uint32_t* ordinals, const float* impacts, size_t count, float* scores);
+
+// scores[ordinals[i]] += impacts[i] * scale.
+void AccumulateQuantizedImpacts(const uint32_t* ordinals, const uint16_t* impacts, float scale, size_t count, float* scores);
+
+std::string_view GetImpactKernelName();
@@ -0,0 +1,134 @@
+#include "index_snapshot.h"
+
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "binary_io.h"
+
+using namespace std::string_literals;
+
+namespace {
+    const std::string_view SNAPSHOT_MAGIC = "SRCHSNP2";
+}
+
+void SaveSnapshot(const SearchServer& search_server, uint64_t lsn, const std::string& path)
+{
+    std::string contents(SNAPSHOT_MAGIC);
+    AppendUint64(contents, lsn);
+
+    AppendUint32(contents, static_cast<uint32_t>(search_server.stop_words_.size()));
+    for (const std::string& stop_word : search_server.stop_words_) {
+        AppendString(contents, stop_word);
+    }
+
+    AppendUint32(contents, static_cast<uint32_t>(search_server.documents_.size()));
+    for (const auto& [document_id, document_data] : search_server.documents_) {
+        AppendUint32(contents, static_cast<uint32_t>(document_id));
+        AppendUint32(contents, static_cast<uint32_t>(document_data.rating));
+        AppendUint8(contents, static_cast<uint8_t>(document_data.status));
+        AppendUint32(contents, document_data.word_count);
+    }
+
+    // Postings rather than per-document words: loading then appends to every
+    // map instead of inserting into the middle.
+    uint32_t word_count = 0;
+    for (const auto& [_, document_freqs] : search_server.word_to_document_freqs_) {
+        word_count += document_freqs.empty() ? 0 : 1;
+    }
+    AppendUint32(contents, word_count);
+    for (const auto& [word, document_freqs] : search_server.word_to_document_freqs_) {
+        if (document_freqs.empty()) {
+            continue;
+        }
+        AppendString(contents, word);
+        AppendUint32(contents, static_cast<uint32_t>(document_freqs.size()));
+        for (const auto& [document_id, term_freq] : document_freqs) {
+            AppendUint32(contents, static_cast<uint32_t>(document_id));
+            AppendDouble(contents, term_freq);
+        }
+    }
+
+    AppendUint32(contents, ComputeCrc32(contents));
+    WriteFileAtomically(path, contents);
+}
+
+IndexSnapshot LoadSnapshot(const std::string& path)
+{
+    IndexSnapshot snapshot;
+    std::string contents;
+    if (!ReadFileContents(path, contents)) {
+        return snapshot;
+    }
+
+    const std::runtime_error corrupt("Corrupt index snapshot "s + path);
+    if (contents.size() < SNAPSHOT_MAGIC.size() + 4
+        || std::string_view(contents).substr(0, SNAPSHOT_MAGIC.size()) != SNAPSHOT_MAGIC) {
+        throw corrupt;
+    }
+    const std::string_view body = std::string_view(contents).substr(0, contents.size() - 4);
+    uint32_t checksum = 0;
+    BinaryReader checksum_reader(std::string_view(contents).substr(body.size()));
+    if (!checksum_reader.ReadUint32(checksum) || ComputeCrc32(body) != checksum) {
+        throw corrupt;
+    }
+
+    BinaryReader reader(body.substr(SNAPSHOT_MAGIC.size()));
+    uint32_t stop_word_count = 0;
+    if (!reader.ReadUint64(snapshot.lsn) || !reader.ReadUint32(stop_word_count)) {
+        throw corrupt;
+    }
+    std::vector<std::string_view> stop_words(stop_word_count);
+    for (std::string_view& stop_word : stop_words) {
+        if (!reader.ReadString(stop_word)) {
+            throw corrupt;
+        }
+    }
+    auto search_server = std::make_unique<SearchServer>(stop_words);
+
+    uint32_t document_count = 0;
+    if (!reader.ReadUint32(document_count)) {
+        throw corrupt;
+    }
+    for (uint32_t i = 0; i < document_count; ++i) {
+        uint32_t document_id = 0;
+        uint32_t rating = 0;
+        uint8_t status = 0;
+        uint32_t word_count = 0;
+        if (!reader.ReadUint32(document_id) || !reader.ReadUint32(rating) || !reader.ReadUint8(status)
+            || !reader.ReadUint32(word_count)) {
+            throw corrupt;
+        }
+        search_server->RestoreDocument(static_cast<int>(document_id), static_cast<DocumentStatus>(status),
+            static_cast<int>(rating), word_count);
+    }
+
+    uint32_t word_count = 0;
+    if (!reader.ReadUint32(word_count)) {
+        throw corrupt;
+    }
+    std::vector<std::pair<int, double>> postings;
+    for (uint32_t i = 0; i < word_count; ++i) {
+        std::string_view word;
+        uint32_t posting_count = 0;
+        if (!reader.ReadString(word) || !reader.ReadUint32(posting_count)) {
+            throw corrupt;
+        }
+        postings.resize(posting_count);
+        for (auto& [document_id, term_freq] : postings) {
+            uint32_t stored_id = 0;
+            if (!reader.ReadUint32(stored_id) || !reader.ReadDouble(term_freq)) {
+                throw corrupt;
+            }
+            document_id = static_cast<int>(stored_id);
+        }
+        search_server->RestoreWord(word, postings);
+    }
+    if (!reader.IsEnd()) {
+        throw corrupt;
+    }
+    search_server->RebuildForwardIndex();
+
+    snapshot.search_server = std::move(search_server);
+    return snapshot;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "search_server.h"
+
+struct IndexSnapshot {
+    std::unique_ptr<SearchServer> search_server;
+    // The last write-ahead log record the snapshot includes.
+    uint64_t lsn = 0;
+};
+
+// Stores stop words, ratings, statuses and word frequencies, so loading skips
+// tokenization. Written atomically and protected by a CRC-32.
+void SaveSnapshot(const SearchServer& search_server, uint64_t lsn, const std::string& path);
+
+// Returns a snapshot without a server when the file does not exist. Throws
+// std::runtime_error when it is not a valid snapshot.
+IndexSnapshot LoadSnapshot(const std::string& path);
@@ -0,0 +1,164 @@
+#include "load_generator.h"
+#include "corpus_generator.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std::string_literals;
+
+namespace {
+
+    class Client {
+    public:
+        Client(const std::string& host, uint16_t port) {
+            socket_ = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port);
+            if (socket_ < 0 || inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1
+                || connect(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+                const std::string error = std::strerror(errno);
+                if (socket_ >= 0) {
+                    close(socket_);
+                }
+                throw std::runtime_error("Unable to connect to "s + host + ':' + std::to_string(port) + ": "s + error);
+            }
+            const int enable = 1;
+            setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+
+        Client(const Client&) = delete;
+        Client& operator=(const Client&) = delete;
+
+        ~Client() {
+            close(socket_);
+        }
+
+        std::string Call(const std::string& request) {
+            const std::string line = request + '\n';
+            for (size_t sent = 0; sent < line.size();) {
+                const ssize_t written = send(socket_, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+                if (written <= 0) {
+                    throw std::runtime_error("Connection lost"s);
+                }
+                sent += static_cast<size_t>(written);
+            }
+
+            size_t newline = buffer_.find('\n');
+            while (newline == std::string::npos) {
+                char chunk[16384];
+                const ssize_t received = recv(socket_, chunk, sizeof(chunk), 0);
+                if (received <= 0) {
+                    throw std::runtime_error("Connection lost"s);
+                }
+                buffer_.append(chunk, static_cast<size_t>(received));
+                newline = buffer_.find('\n');
+            }
+            std::string response = buffer_.substr(0, newline);
+            buffer_.erase(0, newline + 1);
+            return response;
+        }
+
+    private:
+        int socket_ = -1;
+        std::string buffer_;
+    };
+
+    std::chrono::nanoseconds Percentile(const std::vector<std::chrono::nanoseconds>& sorted, double fraction) {
+        if (sorted.empty()) {
+            return std::chrono::nanoseconds(0);
+        }
+        const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+        return sorted[index];
+    }
+
+}
+
+LoadReport RunLoadGenerator(const LoadGeneratorOptions& options)
+{
+    using namespace std::chrono;
+
+    CorpusOptions corpus_options;
+    corpus_options.document_count = options.document_count;
+    corpus_options.seed = options.seed;
+    {
+        Client client(options.host, options.port);
+        for (const GeneratedDocument& document : GenerateCorpus(corpus_options)) {
+            std::string request = "ADD "s + std::to_string(document.id) + " ACTUAL "s;
+            for (size_t i = 0; i < document.ratings.size(); ++i) {
+                request += (i == 0 ? ""s : ","s) + std::to_string(document.ratings[i]);
+            }
+            request += document.ratings.empty() ? "- "s : " "s;
+            client.Call(request + document.text);
+        }
+    }
+
+    std::vector<std::vector<nanoseconds>> latencies(options.connections);
+    std::vector<size_t> errors(options.connections);
+    std::vector<std::thread> workers;
+    const auto start = steady_clock::now();
+    const auto stop = start + options.duration;
+
+    for (size_t i = 0; i < options.connections; ++i) {
+        workers.emplace_back([&options, &latencies, &errors, stop, i] {
+            try {
+                Client client(options.host, options.port);
+                QueryLogOptions query_options;
+                query_options.seed = options.seed + static_cast<uint32_t>(i) + 1;
+                const std::vector<std::string> queries = GenerateQueries(query_options);
+                for (size_t j = 0; steady_clock::now() < stop; ++j) {
+                    const auto request_start = steady_clock::now();
+                    const std::string response = client.Call("SEARCH "s + queries[j % queries.size()]);
+                    latencies[i].push_back(duration_cast<nanoseconds>(steady_clock::now() - request_start));
+                    if (response.compare(0, 2, "OK"s) != 0) {
+                        ++errors[i];
+                    }
+                }
+            }
+            catch (const std::exception&) {
+                ++errors[i];
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start);
+
+    std::vector<nanoseconds> all_latencies;
+    LoadReport report;
+    for (size_t i = 0; i < options.connections; ++i) {
+        all_latencies.insert(all_latencies.end(), latencies[i].begin(), latencies[i].end());
+        report.errors += errors[i];
+    }
+    std::sort(all_latencies.begin(), all_latencies.end());
+
+    report.requests = all_latencies.size();
+    report.queries_per_second = report.requests / elapsed.count();
+    report.p50 = Percentile(all_latencies, 0.5);
+    report.p99 = Percentile(all_latencies, 0.99);
+    report.p999 = Percentile(all_latencies, 0.999);
+    report.max = all_latencies.empty() ? nanoseconds(0) : all_latencies.back();
+    return report;
+}
+
+std::ostream& operator<<(std::ostream& out, const LoadReport& report)
+{
+    using namespace std::chrono;
+    return out << "requests = "s << report.requests << ", errors = "s << report.errors
+        << ", qps = "s << static_cast<long long>(report.queries_per_second)
+        << ", p50 = "s << duration_cast<microseconds>(report.p50).count() << " us"s
+        << ", p99 = "s << duration_cast<microseconds>(report.p99).count() << " us"s
+        << ", p999 = "s << duration_cast<microseconds>(report.p999).count() << " us"s
+        << ", max = "s << duration_cast<microseconds>(report.max).count() << " us"s;
+}
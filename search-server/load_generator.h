@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+struct LoadGeneratorOptions {
+    std::string host = "127.0.0.1";
+    uint16_t port = 8080;
+    size_t connections = 8;
+    std::chrono::seconds duration{ 10 };
+    size_t document_count = 10000;
+    uint32_t seed = 42;
+};
+
+struct LoadReport {
+    size_t requests = 0;
+    size_t errors = 0;
+    double queries_per_second = 0.0;
+    std::chrono::nanoseconds p50{ 0 };
+    std::chrono::nanoseconds p99{ 0 };
+    std::chrono::nanoseconds p999{ 0 };
+    std::chrono::nanoseconds max{ 0 };
+};
+
+// Fills the service with generated documents and then keeps every connection
+// busy with closed-loop SEARCH requests for the configured duration.
+LoadReport RunLoadGenerator(const LoadGeneratorOptions& options);
+
+std::ostream& operator<<(std::ostream& out, const LoadReport& report);
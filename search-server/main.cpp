@@ -8,10 +8,17 @@
 #include <numeric>
 #include <execution>
 #include <cassert>
+#include <fstream>
+#include <cstdlib>
+
+#include <unistd.h>
 
 #include "process_queries.h"
 #include "search_server.h"
 #include "log_duration.h"
+#include "query_service.h"
+#include "load_generator.h"
+#include "benchmark.h"
 
 using namespace std;
 void PrintDocument(const Document& document) {
@@ -20,7 +27,96 @@ void PrintDocument(const Document& document) {
         << "relevance = "s << document.relevance << ", "s
         << "rating = "s << document.rating << " }"s << endl;
 }
-int main() {
+int RunService(int argc, char* argv[]) {
+    QueryServiceOptions options;
+    if (argc >= 3) {
+        options.port = static_cast<uint16_t>(stoi(argv[2]));
+    }
+    string stop_words;
+    for (int i = 3; i < argc; ++i) {
+        stop_words += argv[i] + " "s;
+    }
+    SearchServer search_server(stop_words);
+    QueryService service(search_server, options);
+    cerr << "Listening on port "s << service.GetPort() << endl;
+    service.Run();
+    return 0;
+}
+int RunLoad(int argc, char* argv[]) {
+    LoadGeneratorOptions options;
+    if (argc >= 3) {
+        options.port = static_cast<uint16_t>(stoi(argv[2]));
+    }
+    if (argc >= 4) {
+        options.connections = stoul(argv[3]);
+    }
+    if (argc >= 5) {
+        options.duration = chrono::seconds(stoi(argv[4]));
+    }
+    cout << RunLoadGenerator(options) << endl;
+    return 0;
+}
+int RunBenchmarkSuite(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    if (argc >= 3) {
+        options.corpus.document_count = stoul(argv[2]);
+    }
+    if (argc >= 4) {
+        options.queries.query_count = stoul(argv[3]);
+    }
+    if (CheckImpactRanking(options, cout) != 0) {
+        return 1;
+    }
+    if (CheckShardedSearch(options, cout) != 0) {
+        return 1;
+    }
+    if (CheckCursorPagination(options, cout) != 0) {
+        return 1;
+    }
+    if (CheckQueryBudget(options, cout) != 0) {
+        return 1;
+    }
+    char index_directory[] = "/tmp/search-server-bench-XXXXXX";
+    if (mkdtemp(index_directory) == nullptr) {
+        cerr << "Unable to create a directory for the durable index"s << endl;
+        return 1;
+    }
+    if (CheckCrashRecovery(options, index_directory, cout) != 0) {
+        rmdir(index_directory);
+        return 1;
+    }
+    PrintIndexMemory(options, cout);
+    auto results = RunBenchmarks(options);
+    for (BenchmarkResult& result : RunRecoveryBenchmarks(options, index_directory)) {
+        results.push_back(move(result));
+    }
+    rmdir(index_directory);
+    for (const BenchmarkResult& result : results) {
+        cout << result << endl;
+    }
+    if (argc >= 5) {
+        ifstream baseline(argv[4]);
+        if (baseline) {
+            return CompareWithBaseline(baseline, results, BaselineTolerance(), cout) == 0 ? 0 : 1;
+        }
+        ofstream output(argv[4]);
+        WriteBenchmarkResults(output, results);
+    }
+    return 0;
+}
+int main(int argc, char* argv[]) {
+    // search-server serve [port] [stop words...]
+    if (argc >= 2 && argv[1] == "serve"s) {
+        return RunService(argc, argv);
+    }
+    // search-server loadgen [port] [connections] [seconds]
+    if (argc >= 2 && argv[1] == "loadgen"s) {
+        return RunLoad(argc, argv);
+    }
+    // search-server bench [documents] [queries] [baseline file: compared if present, written otherwise]
+    if (argc >= 2 && argv[1] == "bench"s) {
+        return RunBenchmarkSuite(argc, argv);
+    }
     SearchServer search_server("and with"s);
     int id = 0;
     for (
@@ -0,0 +1,226 @@
+#include "metrics.h"
+
+#include <cstdlib>
+#include <new>
+
+using namespace std::string_literals;
+
+namespace {
+
+    const std::array<std::string_view, METRIC_COUNTER_COUNT> COUNTER_NAMES = {
+        "queries",
+        "postings_scanned",
+        "documents_scored",
+        "allocations",
+        "truncated_queries",
+        "wal_syncs",
+    };
+
+    const std::array<std::string_view, METRIC_TIMER_COUNT> TIMER_NAMES = {
+        "add_document",
+        "remove_document",
+        "find_top_documents",
+        "match_document",
+    };
+
+    const std::array<double, 4> EXPORTED_PERCENTILES = { 0.5, 0.9, 0.99, 0.999 };
+
+#ifdef SEARCH_SERVER_METRICS
+    thread_local ThreadMetrics thread_metrics;
+#endif
+
+}
+
+size_t GetHistogramBucket(uint64_t value)
+{
+    if (value < HISTOGRAM_SUB_BUCKET_COUNT) {
+        return static_cast<size_t>(value);
+    }
+    int exponent = 63;
+    while ((value >> exponent) == 0) {
+        --exponent;
+    }
+    const size_t sub_bucket = static_cast<size_t>(value >> (exponent - HISTOGRAM_SUB_BUCKET_BITS)) & (HISTOGRAM_SUB_BUCKET_COUNT - 1);
+    return (exponent - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKET_COUNT + sub_bucket;
+}
+
+uint64_t GetHistogramBucketLowerBound(size_t bucket)
+{
+    if (bucket < HISTOGRAM_SUB_BUCKET_COUNT) {
+        return bucket;
+    }
+    const int exponent = static_cast<int>(bucket / HISTOGRAM_SUB_BUCKET_COUNT) + HISTOGRAM_SUB_BUCKET_BITS - 1;
+    const uint64_t sub_bucket = bucket % HISTOGRAM_SUB_BUCKET_COUNT;
+    return (HISTOGRAM_SUB_BUCKET_COUNT + sub_bucket) << (exponent - HISTOGRAM_SUB_BUCKET_BITS);
+}
+
+uint64_t HistogramSnapshot::GetPercentile(double fraction) const
+{
+    const double threshold = fraction * count;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen > 0 && seen >= threshold) {
+            return GetHistogramBucketLowerBound(i);
+        }
+    }
+    return 0;
+}
+
+uint64_t MetricsSnapshot::GetCounter(MetricCounter counter) const
+{
+    return counters[static_cast<size_t>(counter)];
+}
+
+const HistogramSnapshot& MetricsSnapshot::GetTimer(MetricTimer timer) const
+{
+    return timers[static_cast<size_t>(timer)];
+}
+
+std::string_view GetMetricName(MetricCounter counter)
+{
+    return COUNTER_NAMES[static_cast<size_t>(counter)];
+}
+
+std::string_view GetMetricName(MetricTimer timer)
+{
+    return TIMER_NAMES[static_cast<size_t>(timer)];
+}
+
+#ifdef SEARCH_SERVER_METRICS
+
+ThreadMetrics::~ThreadMetrics()
+{
+    if (registered && !retired) {
+        MetricsRegistry::Instance().Retire(this);
+    }
+    retired = true;
+}
+
+void ThreadMetrics::AddTo(MetricsSnapshot& snapshot) const
+{
+    for (size_t i = 0; i < METRIC_COUNTER_COUNT; ++i) {
+        snapshot.counters[i] += counters[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < METRIC_TIMER_COUNT; ++i) {
+        HistogramSnapshot& histogram = snapshot.timers[i];
+        for (size_t j = 0; j < HISTOGRAM_BUCKET_COUNT; ++j) {
+            const uint64_t bucket_count = timer_buckets[i][j].load(std::memory_order_relaxed);
+            histogram.buckets[j] += bucket_count;
+            histogram.count += bucket_count;
+        }
+        histogram.sum += timer_sums[i].load(std::memory_order_relaxed);
+    }
+}
+
+MetricsRegistry& MetricsRegistry::Instance()
+{
+    // Never destroyed and never heap allocated: threads may still record
+    // during static destruction, and operator new itself records metrics.
+    alignas(MetricsRegistry) static unsigned char storage[sizeof(MetricsRegistry)];
+    static MetricsRegistry* instance = new (storage) MetricsRegistry();
+    return *instance;
+}
+
+MetricsSnapshot MetricsRegistry::GetSnapshot() const
+{
+    std::lock_guard guard(mutex_);
+    MetricsSnapshot snapshot = retired_;
+    for (const ThreadMetrics* thread : threads_) {
+        thread->AddTo(snapshot);
+    }
+    return snapshot;
+}
+
+void MetricsRegistry::Register(ThreadMetrics* thread_metrics)
+{
+    std::lock_guard guard(mutex_);
+    threads_.push_back(thread_metrics);
+}
+
+void MetricsRegistry::Retire(ThreadMetrics* thread_metrics)
+{
+    std::lock_guard guard(mutex_);
+    thread_metrics->AddTo(retired_);
+    threads_.erase(std::remove(threads_.begin(), threads_.end(), thread_metrics), threads_.end());
+}
+
+ThreadMetrics& GetThreadMetrics()
+{
+    if (!thread_metrics.registered) {
+        // Set first: registering allocates, and allocations are counted on this thread.
+        thread_metrics.registered = true;
+        MetricsRegistry::Instance().Register(&thread_metrics);
+    }
+    return thread_metrics;
+}
+
+#endif
+
+MetricsSnapshot GetMetricsSnapshot()
+{
+#ifdef SEARCH_SERVER_METRICS
+    return MetricsRegistry::Instance().GetSnapshot();
+#else
+    return {};
+#endif
+}
+
+void PrintMetrics(std::ostream& out, const MetricsSnapshot& snapshot)
+{
+    for (size_t i = 0; i < METRIC_COUNTER_COUNT; ++i) {
+        out << COUNTER_NAMES[i] << ": "s << snapshot.counters[i] << std::endl;
+    }
+    for (size_t i = 0; i < METRIC_TIMER_COUNT; ++i) {
+        const HistogramSnapshot& histogram = snapshot.timers[i];
+        out << TIMER_NAMES[i] << ": count = "s << histogram.count;
+        if (histogram.count > 0) {
+            out << ", mean = "s << histogram.sum / histogram.count << " ns"s;
+            for (double fraction : EXPORTED_PERCENTILES) {
+                out << ", p"s << fraction * 100 << " = "s << histogram.GetPercentile(fraction) << " ns"s;
+            }
+        }
+        out << std::endl;
+    }
+}
+
+void PrintPrometheusMetrics(std::ostream& out, const MetricsSnapshot& snapshot)
+{
+    for (size_t i = 0; i < METRIC_COUNTER_COUNT; ++i) {
+        out << "# TYPE search_server_"s << COUNTER_NAMES[i] << "_total counter\n"s;
+        out << "search_server_"s << COUNTER_NAMES[i] << "_total "s << snapshot.counters[i] << '\n';
+    }
+    for (size_t i = 0; i < METRIC_TIMER_COUNT; ++i) {
+        const HistogramSnapshot& histogram = snapshot.timers[i];
+        const std::string name = "search_server_"s + std::string(TIMER_NAMES[i]) + "_seconds"s;
+        out << "# TYPE "s << name << " summary\n"s;
+        for (double fraction : EXPORTED_PERCENTILES) {
+            out << name << "{quantile=\""s << fraction << "\"} "s << histogram.GetPercentile(fraction) * 1e-9 << '\n';
+        }
+        out << name << "_sum "s << histogram.sum * 1e-9 << '\n';
+        out << name << "_count "s << histogram.count << '\n';
+    }
+}
+
+#ifdef SEARCH_SERVER_METRICS
+
+void* operator new(size_t size)
+{
+    RecordMetric(MetricCounter::ALLOCATIONS, 1);
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+#endif
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "log_duration.h"
+
+// Build with -DSEARCH_SERVER_METRICS to record metrics. Without it the
+// METRICS_* macros expand to nothing and the snapshot API reports zeros.
+#ifdef SEARCH_SERVER_METRICS
+constexpr bool METRICS_ENABLED = true;
+#define METRICS_COUNT(counter, value) RecordMetric(counter, value)
+#define METRICS_SCOPED_TIMER(timer) ScopedTimer UNIQUE_VAR_NAME_PROFILE(timer)
+#else
+constexpr bool METRICS_ENABLED = false;
+#define METRICS_COUNT(counter, value) static_cast<void>(0)
+#define METRICS_SCOPED_TIMER(timer) static_cast<void>(0)
+#endif
+
+enum class MetricCounter {
+    QUERIES,
+    POSTINGS_SCANNED,
+    DOCUMENTS_SCORED,
+    ALLOCATIONS,
+    TRUNCATED_QUERIES,
+    WAL_SYNCS,
+    COUNT,
+};
+
+enum class MetricTimer {
+    ADD_DOCUMENT,
+    REMOVE_DOCUMENT,
+    FIND_TOP_DOCUMENTS,
+    MATCH_DOCUMENT,
+    COUNT,
+};
+
+const size_t METRIC_COUNTER_COUNT = static_cast<size_t>(MetricCounter::COUNT);
+const size_t METRIC_TIMER_COUNT = static_cast<size_t>(MetricTimer::COUNT);
+
+// Log-linear buckets in the spirit of HdrHistogram: every power of two is split
+// into 8 sub-buckets, so a recorded value is off by at most 12.5%.
+const int HISTOGRAM_SUB_BUCKET_BITS = 3;
+const size_t HISTOGRAM_SUB_BUCKET_COUNT = size_t{ 1 } << HISTOGRAM_SUB_BUCKET_BITS;
+const size_t HISTOGRAM_BUCKET_COUNT = (64 - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKET_COUNT;
+
+size_t GetHistogramBucket(uint64_t value);
+
+uint64_t GetHistogramBucketLowerBound(size_t bucket);
+
+struct HistogramSnapshot {
+    std::array<uint64_t, HISTOGRAM_BUCKET_COUNT> buckets{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+
+    uint64_t GetPercentile(double fraction) const;
+};
+
+struct MetricsSnapshot {
+    std::array<uint64_t, METRIC_COUNTER_COUNT> counters{};
+    // Nanoseconds.
+    std::array<HistogramSnapshot, METRIC_TIMER_COUNT> timers{};
+
+    uint64_t GetCounter(MetricCounter counter) const;
+
+    const HistogramSnapshot& GetTimer(MetricTimer timer) const;
+};
+
+std::string_view GetMetricName(MetricCounter counter);
+
+std::string_view GetMetricName(MetricTimer timer);
+
+#ifdef SEARCH_SERVER_METRICS
+
+// Per-thread cells. Only the owning thread writes them; relaxed atomics let
+// the registry read them at any time without tearing.
+struct ThreadMetrics {
+    std::array<std::atomic<uint64_t>, METRIC_COUNTER_COUNT> counters;
+    std::array<std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKET_COUNT>, METRIC_TIMER_COUNT> timer_buckets;
+    std::array<std::atomic<uint64_t>, METRIC_TIMER_COUNT> timer_sums;
+    bool registered;
+    bool retired;
+
+    ~ThreadMetrics();
+
+    void AddTo(MetricsSnapshot& snapshot) const;
+};
+
+class MetricsRegistry {
+public:
+    static MetricsRegistry& Instance();
+
+    MetricsSnapshot GetSnapshot() const;
+
+    void Register(ThreadMetrics* thread_metrics);
+
+    void Retire(ThreadMetrics* thread_metrics);
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<ThreadMetrics*> threads_;
+    MetricsSnapshot retired_;
+};
+
+ThreadMetrics& GetThreadMetrics();
+
+inline void RecordMetric(MetricCounter counter, uint64_t value) {
+    auto& cell = GetThreadMetrics().counters[static_cast<size_t>(counter)];
+    cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+inline void RecordMetric(MetricTimer timer, std::chrono::nanoseconds duration) {
+    ThreadMetrics& thread_metrics = GetThreadMetrics();
+    const uint64_t value = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+    auto& bucket = thread_metrics.timer_buckets[static_cast<size_t>(timer)][GetHistogramBucket(value)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    auto& sum = thread_metrics.timer_sums[static_cast<size_t>(timer)];
+    sum.store(sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+class ScopedTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ScopedTimer(MetricTimer timer) : timer_(timer) {
+    }
+
+    ~ScopedTimer() {
+        RecordMetric(timer_, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time_));
+    }
+
+private:
+    const MetricTimer timer_;
+    const Clock::time_point start_time_ = Clock::now();
+};
+
+#endif
+
+// Empty when metrics are not built in.
+MetricsSnapshot GetMetricsSnapshot();
+
+void PrintMetrics(std::ostream& out, const MetricsSnapshot& snapshot);
+
+void PrintPrometheusMetrics(std::ostream& out, const MetricsSnapshot& snapshot);
@@ -3,13 +3,71 @@
 std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries) {
 
     std::vector<std::vector<Document>> ret_vec(queries.size());
-    
-    std::transform(std::execution::par, queries.begin(), queries.end(), ret_vec.begin(), 
-        [&search_server](const std::string& query) { return search_server.FindTopDocuments(query); });
-    
+
+    auto outcomes = ProcessQueriesOutcomes(search_server, queries);
+    for (size_t i = 0; i < outcomes.size(); ++i) {
+        if (outcomes[i].error) {
+            std::rethrow_exception(outcomes[i].error);
+        }
+        ret_vec[i] = std::move(outcomes[i].documents);
+    }
+
+    return ret_vec;
+}
+
+std::vector<QueryOutcome> ProcessQueriesOutcomes(const SearchServer& search_server, const std::vector<std::string>& queries) {
+
+    std::vector<QueryOutcome> ret_vec(queries.size());
+
+    std::transform(std::execution::par, queries.begin(), queries.end(), ret_vec.begin(),
+        [&search_server](const std::string& query) {
+            QueryOutcome outcome;
+            try {
+                outcome.documents = search_server.FindTopDocuments(query);
+            }
+            catch (...) {
+                outcome.error = std::current_exception();
+            }
+            return outcome;
+        });
+
+    return ret_vec;
+}
+
+std::vector<PartialResult> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries, const QueryBudget& budget) {
+
+    std::vector<PartialResult> ret_vec(queries.size());
+    std::vector<std::exception_ptr> errors(queries.size());
+    std::vector<size_t> indexes(queries.size());
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        indexes[i] = i;
+    }
+
+    std::for_each(std::execution::par, indexes.begin(), indexes.end(),
+        [&search_server, &queries, &budget, &ret_vec, &errors](size_t i) {
+            try {
+                ret_vec[i] = search_server.FindTopDocuments(queries[i], budget);
+            }
+            catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
     return ret_vec;
 }
 
+std::future<PartialResult> FindTopDocumentsAsync(const SearchServer& search_server, std::string raw_query, QueryBudget budget)
+{
+    return std::async(std::launch::async, [&search_server, raw_query = std::move(raw_query), budget = std::move(budget)] {
+        return search_server.FindTopDocuments(raw_query, budget);
+    });
+}
+
 std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries)
 {
     std::vector<Document> ret_vec_int{};
@@ -1,12 +1,34 @@
 #pragma once
+#include <exception>
 #include <functional>
 #include <execution>
+#include <future>
 #include "search_server.h"
 
+struct QueryOutcome {
+    std::vector<Document> documents;
+    std::exception_ptr error;
+};
+
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
 
+std::vector<QueryOutcome> ProcessQueriesOutcomes(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries);
+
+// Every query gets the same budget; results past it are flagged as truncated.
+std::vector<PartialResult> ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    const QueryBudget& budget);
+
+std::future<PartialResult> FindTopDocumentsAsync(
+    const SearchServer& search_server,
+    std::string raw_query,
+    QueryBudget budget);
+
 std::vector<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
-    const std::vector<std::string>& queries);
\ No newline at end of file
+    const std::vector<std::string>& queries);
@@ -0,0 +1,42 @@
+#include "query_budget.h"
+
+bool CancellationToken::IsCancelled() const
+{
+    return cancelled_ != nullptr && cancelled_->load(std::memory_order_relaxed);
+}
+
+CancellationToken::CancellationToken(std::shared_ptr<const std::atomic<bool>> cancelled)
+    : cancelled_(std::move(cancelled))
+{
+}
+
+CancellationSource::CancellationSource()
+    : cancelled_(std::make_shared<std::atomic<bool>>(false))
+{
+}
+
+void CancellationSource::Cancel()
+{
+    cancelled_->store(true, std::memory_order_relaxed);
+}
+
+CancellationToken CancellationSource::GetToken() const
+{
+    return CancellationToken(cancelled_);
+}
+
+QueryBudget::QueryBudget(Clock::time_point deadline, CancellationToken token)
+    : deadline_(deadline)
+    , token_(std::move(token))
+{
+}
+
+QueryBudget QueryBudget::WithTimeout(Clock::duration timeout, CancellationToken token)
+{
+    return QueryBudget(Clock::now() + timeout, std::move(token));
+}
+
+bool QueryBudget::IsExhausted() const
+{
+    return token_.IsCancelled() || Clock::now() >= deadline_;
+}
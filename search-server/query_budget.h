@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "document.h"
+
+class CancellationToken {
+public:
+    // A default token is never cancelled.
+    CancellationToken() = default;
+
+    bool IsCancelled() const;
+
+private:
+    friend class CancellationSource;
+
+    explicit CancellationToken(std::shared_ptr<const std::atomic<bool>> cancelled);
+
+    std::shared_ptr<const std::atomic<bool>> cancelled_;
+};
+
+class CancellationSource {
+public:
+    CancellationSource();
+
+    void Cancel();
+
+    CancellationToken GetToken() const;
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
+// Time and cancellation limit of a query. The scoring loop polls it once per
+// block of postings, so a query may overrun the deadline by about one block.
+class QueryBudget {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Unlimited.
+    QueryBudget() = default;
+
+    explicit QueryBudget(Clock::time_point deadline, CancellationToken token = {});
+
+    static QueryBudget WithTimeout(Clock::duration timeout, CancellationToken token = {});
+
+    bool IsExhausted() const;
+
+private:
+    Clock::time_point deadline_ = Clock::time_point::max();
+    CancellationToken token_;
+};
+
+struct PartialResult {
+    std::vector<Document> documents;
+    // Set when the budget ran out before every posting was scored; documents
+    // then hold the best of what was scored.
+    bool truncated = false;
+};
@@ -0,0 +1,461 @@
+#include "query_service.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "process_queries.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+    const std::string_view SEARCH_COMMAND = "SEARCH ";
+
+    std::runtime_error SystemError(const std::string& what) {
+        return std::runtime_error(what + ": "s + std::strerror(errno));
+    }
+
+    std::string_view NextToken(std::string_view& text) {
+        const size_t end = text.find(' ');
+        const std::string_view token = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        return token;
+    }
+
+    int ParseInt(std::string_view token) {
+        size_t parsed = 0;
+        const int value = std::stoi(std::string(token), &parsed);
+        if (parsed != token.size()) {
+            throw std::invalid_argument("Invalid number "s + std::string(token));
+        }
+        return value;
+    }
+
+    DocumentStatus ParseStatus(std::string_view token) {
+        if (token == "ACTUAL") {
+            return DocumentStatus::ACTUAL;
+        }
+        if (token == "IRRELEVANT") {
+            return DocumentStatus::IRRELEVANT;
+        }
+        if (token == "BANNED") {
+            return DocumentStatus::BANNED;
+        }
+        if (token == "REMOVED") {
+            return DocumentStatus::REMOVED;
+        }
+        throw std::invalid_argument("Invalid document status "s + std::string(token));
+    }
+
+    std::string_view StatusName(DocumentStatus status) {
+        switch (status) {
+        case DocumentStatus::ACTUAL:
+            return "ACTUAL";
+        case DocumentStatus::IRRELEVANT:
+            return "IRRELEVANT";
+        case DocumentStatus::BANNED:
+            return "BANNED";
+        case DocumentStatus::REMOVED:
+            return "REMOVED";
+        }
+        return "UNKNOWN";
+    }
+
+    std::string ErrorResponse(std::string message) {
+        for (char& c : message) {
+            if (c >= '\0' && c < ' ') {
+                c = '?';
+            }
+        }
+        return "ERR "s + message;
+    }
+
+    std::string FormatDocuments(const std::vector<Document>& documents) {
+        std::ostringstream out;
+        out << "OK "s << documents.size();
+        for (const Document& document : documents) {
+            out << ' ' << document.id << ' ' << document.relevance << ' ' << document.rating;
+        }
+        return out.str();
+    }
+
+}
+
+QueryService::QueryService(SearchServer& search_server, const QueryServiceOptions& options)
+    : search_server_(search_server)
+    , options_(options)
+{
+    listen_socket_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (listen_socket_ < 0) {
+        throw SystemError("socket"s);
+    }
+
+    const int enable = 1;
+    setsockopt(listen_socket_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(options_.port);
+    if (bind(listen_socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || listen(listen_socket_, SOMAXCONN) != 0) {
+        close(listen_socket_);
+        throw SystemError("Unable to listen on port "s + std::to_string(options_.port));
+    }
+
+    socklen_t address_length = sizeof(address);
+    getsockname(listen_socket_, reinterpret_cast<sockaddr*>(&address), &address_length);
+    options_.port = ntohs(address.sin_port);
+
+    epoll_ = epoll_create1(0);
+    wake_event_ = eventfd(0, EFD_NONBLOCK);
+    if (epoll_ < 0 || wake_event_ < 0) {
+        close(listen_socket_);
+        throw SystemError("epoll"s);
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listen_socket_;
+    epoll_ctl(epoll_, EPOLL_CTL_ADD, listen_socket_, &event);
+    event.data.fd = wake_event_;
+    epoll_ctl(epoll_, EPOLL_CTL_ADD, wake_event_, &event);
+}
+
+QueryService::~QueryService()
+{
+    for (const auto& [socket, _] : connections_) {
+        close(socket);
+    }
+    close(wake_event_);
+    close(epoll_);
+    close(listen_socket_);
+}
+
+void QueryService::Run()
+{
+    using namespace std::chrono;
+
+    std::vector<epoll_event> events(256);
+    bool running = true;
+    while (running) {
+        int timeout = -1;
+        if (!pending_.empty()) {
+            const auto remaining = options_.batch_delay - duration_cast<microseconds>(steady_clock::now() - first_pending_time_);
+            timeout = remaining.count() <= 0 ? 0 : static_cast<int>((remaining.count() + 999) / 1000);
+        }
+
+        const int count = epoll_wait(epoll_, events.data(), static_cast<int>(events.size()), timeout);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw SystemError("epoll_wait"s);
+        }
+
+        for (int i = 0; i < count; ++i) {
+            const int socket = events[i].data.fd;
+            if (socket == listen_socket_) {
+                AcceptConnections();
+            }
+            else if (socket == wake_event_) {
+                running = false;
+            }
+            else {
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    ReadConnection(socket);
+                }
+                if ((events[i].events & EPOLLOUT) && connections_.count(socket) != 0) {
+                    WriteConnection(socket);
+                }
+            }
+        }
+
+        const bool batch_ready = pending_searches_ >= options_.max_batch_size
+            || pending_.size() > pending_searches_
+            || steady_clock::now() - first_pending_time_ >= options_.batch_delay;
+        if (!pending_.empty() && batch_ready) {
+            ProcessPending();
+        }
+    }
+}
+
+void QueryService::Stop()
+{
+    const uint64_t value = 1;
+    [[maybe_unused]] const ssize_t written = write(wake_event_, &value, sizeof(value));
+}
+
+uint16_t QueryService::GetPort() const
+{
+    return options_.port;
+}
+
+void QueryService::AcceptConnections()
+{
+    while (true) {
+        const int socket = accept4(listen_socket_, nullptr, nullptr, SOCK_NONBLOCK);
+        if (socket < 0) {
+            return;
+        }
+
+        const int enable = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = socket;
+        epoll_ctl(epoll_, EPOLL_CTL_ADD, socket, &event);
+        connections_[socket];
+    }
+}
+
+void QueryService::ReadConnection(int socket)
+{
+    auto it = connections_.find(socket);
+    if (it == connections_.end() || it->second.peer_closed) {
+        return;
+    }
+    Connection& connection = it->second;
+
+    // epoll is level-triggered, so a connection that still has data after
+    // max_read_per_wakeup bytes is reported again by the next epoll_wait and
+    // cannot starve the others.
+    char buffer[16384];
+    size_t read_bytes = 0;
+    while (read_bytes < options_.max_read_per_wakeup) {
+        const ssize_t received = recv(socket, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            const size_t scan_from = connection.input.size();
+            connection.input.append(buffer, static_cast<size_t>(received));
+            read_bytes += static_cast<size_t>(received);
+            QueueLines(socket, connection, scan_from);
+            // Only the unterminated tail is left in input.
+            if (connection.input.size() > options_.max_line_length) {
+                connection.input.clear();
+                connection.peer_closed = true;
+                break;
+            }
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        connection.peer_closed = true;
+        break;
+    }
+
+    if (connection.peer_closed) {
+        epoll_event event{};
+        epoll_ctl(epoll_, EPOLL_CTL_DEL, socket, &event);
+        connection.want_write = false;
+        if (pending_.empty() || std::none_of(pending_.begin(), pending_.end(),
+            [socket](const PendingRequest& request) { return request.socket == socket; })) {
+            CloseConnection(socket);
+        }
+    }
+}
+
+void QueryService::QueueLines(int socket, Connection& connection, size_t scan_from)
+{
+    size_t line_begin = 0;
+    for (size_t newline = connection.input.find('\n', scan_from); newline != std::string::npos;
+        newline = connection.input.find('\n', line_begin)) {
+        std::string line = connection.input.substr(line_begin, newline - line_begin);
+        line_begin = newline + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if (pending_.empty()) {
+            first_pending_time_ = std::chrono::steady_clock::now();
+        }
+        if (line.compare(0, SEARCH_COMMAND.size(), SEARCH_COMMAND) == 0) {
+            ++pending_searches_;
+        }
+        pending_.push_back({ socket, std::move(line) });
+    }
+    connection.input.erase(0, line_begin);
+}
+
+void QueryService::ProcessPending()
+{
+    std::vector<PendingRequest> requests;
+    requests.swap(pending_);
+    pending_searches_ = 0;
+
+    std::unordered_set<int> touched;
+    std::vector<PendingRequest> searches;
+    for (PendingRequest& request : requests) {
+        touched.insert(request.socket);
+        if (request.line.compare(0, SEARCH_COMMAND.size(), SEARCH_COMMAND) == 0) {
+            searches.push_back(std::move(request));
+            if (searches.size() >= options_.max_batch_size) {
+                FlushSearches(searches);
+            }
+            continue;
+        }
+        FlushSearches(searches);
+        const auto connection = connections_.find(request.socket);
+        if (connection != connections_.end()) {
+            connection->second.output += ExecuteCommand(request.line) + '\n';
+        }
+    }
+    FlushSearches(searches);
+
+    for (int socket : touched) {
+        WriteConnection(socket);
+    }
+}
+
+void QueryService::FlushSearches(std::vector<PendingRequest>& searches)
+{
+    if (searches.empty()) {
+        return;
+    }
+
+    std::vector<std::string> queries;
+    queries.reserve(searches.size());
+    for (const PendingRequest& request : searches) {
+        queries.push_back(request.line.substr(SEARCH_COMMAND.size()));
+    }
+
+    const auto outcomes = ProcessQueriesOutcomes(search_server_, queries);
+    for (size_t i = 0; i < outcomes.size(); ++i) {
+        std::string response;
+        if (outcomes[i].error) {
+            try {
+                std::rethrow_exception(outcomes[i].error);
+            }
+            catch (const std::exception& e) {
+                response = ErrorResponse(e.what());
+            }
+        }
+        else {
+            response = FormatDocuments(outcomes[i].documents);
+        }
+        // CloseConnection drops a socket's pending requests, so this only
+        // guards against a socket closed while its batch was being executed.
+        const auto connection = connections_.find(searches[i].socket);
+        if (connection != connections_.end()) {
+            connection->second.output += response + '\n';
+        }
+    }
+    searches.clear();
+}
+
+std::string QueryService::ExecuteCommand(std::string_view line)
+{
+    try {
+        const std::string_view command = NextToken(line);
+        if (command == "ADD") {
+            const int document_id = ParseInt(NextToken(line));
+            const DocumentStatus status = ParseStatus(NextToken(line));
+            std::string_view ratings_text = NextToken(line);
+            std::vector<int> ratings;
+            if (ratings_text != "-") {
+                while (!ratings_text.empty()) {
+                    const size_t comma = ratings_text.find(',');
+                    ratings.push_back(ParseInt(ratings_text.substr(0, comma)));
+                    ratings_text.remove_prefix(comma == std::string_view::npos ? ratings_text.size() : comma + 1);
+                }
+            }
+            search_server_.AddDocument(document_id, line, status, ratings);
+            return "OK"s;
+        }
+        if (command == "REMOVE") {
+            search_server_.RemoveDocument(ParseInt(NextToken(line)));
+            return "OK"s;
+        }
+        if (command == "MATCH") {
+            const int document_id = ParseInt(NextToken(line));
+            const auto [words, status] = search_server_.MatchDocument(line, document_id);
+            std::string response = "OK "s + std::string(StatusName(status));
+            for (std::string_view word : words) {
+                response += ' ';
+                response += word;
+            }
+            return response;
+        }
+        return ErrorResponse("Unknown command "s + std::string(command));
+    }
+    catch (const std::exception& e) {
+        return ErrorResponse(e.what());
+    }
+}
+
+void QueryService::WriteConnection(int socket)
+{
+    auto it = connections_.find(socket);
+    if (it == connections_.end()) {
+        return;
+    }
+    Connection& connection = it->second;
+
+    size_t written_total = 0;
+    bool failed = false;
+    while (written_total < connection.output.size()) {
+        const ssize_t written = send(socket, connection.output.data() + written_total,
+            connection.output.size() - written_total, MSG_NOSIGNAL);
+        if (written > 0) {
+            written_total += static_cast<size_t>(written);
+            continue;
+        }
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        failed = !(written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+        break;
+    }
+    connection.output.erase(0, written_total);
+
+    const bool drained = connection.output.empty();
+    if (failed || (drained && connection.peer_closed)) {
+        CloseConnection(socket);
+        return;
+    }
+
+    if (drained == connection.want_write) {
+        // A closed peer is no longer polled for input, so it is re-added for output only.
+        const int operation = connection.peer_closed ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+        connection.want_write = !drained;
+        epoll_event event{};
+        event.events = connection.peer_closed ? EPOLLOUT : (connection.want_write ? EPOLLIN | EPOLLOUT : EPOLLIN);
+        event.data.fd = socket;
+        epoll_ctl(epoll_, operation, socket, &event);
+    }
+}
+
+void QueryService::CloseConnection(int socket)
+{
+    // The socket number may be reused by the next accept, so requests still
+    // queued from it must not be answered there.
+    const auto removed = std::remove_if(pending_.begin(), pending_.end(),
+        [socket](const PendingRequest& request) { return request.socket == socket; });
+    for (auto it = removed; it != pending_.end(); ++it) {
+        if (it->line.compare(0, SEARCH_COMMAND.size(), SEARCH_COMMAND) == 0) {
+            --pending_searches_;
+        }
+    }
+    pending_.erase(removed, pending_.end());
+
+    epoll_event event{};
+    epoll_ctl(epoll_, EPOLL_CTL_DEL, socket, &event);
+    close(socket);
+    connections_.erase(socket);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "search_server.h"
+
+// Line-based TCP front end for a SearchServer. One request per line:
+//   SEARCH <query>                        -> OK <count> [<id> <relevance> <rating>]...
+//   ADD <id> <status> <ratings> <text>    -> OK        (ratings: comma separated or "-")
+//   REMOVE <id>                           -> OK
+//   MATCH <id> <query>                    -> OK <status> [<word>]...
+// Failures are answered with "ERR <message>".
+//
+// All sockets are served by one epoll loop. Consecutive SEARCH requests from all
+// connections are collected into a batch and executed through
+// ProcessQueriesOutcomes; ADD, REMOVE and MATCH flush the batch first, so every
+// connection observes its own requests in order.
+struct QueryServiceOptions {
+    uint16_t port = 8080;
+    size_t max_batch_size = 256;
+    std::chrono::microseconds batch_delay{ 0 };
+    size_t max_line_length = 1 << 20;
+    // Bytes read from one connection per epoll wakeup.
+    size_t max_read_per_wakeup = 256 << 10;
+};
+
+class QueryService {
+public:
+    QueryService(SearchServer& search_server, const QueryServiceOptions& options);
+
+    QueryService(const QueryService&) = delete;
+    QueryService& operator=(const QueryService&) = delete;
+
+    ~QueryService();
+
+    // Serves requests until Stop() is called.
+    void Run();
+
+    // May be called from any thread.
+    void Stop();
+
+    uint16_t GetPort() const;
+
+private:
+    struct Connection {
+        std::string input;
+        std::string output;
+        bool peer_closed = false;
+        bool want_write = false;
+    };
+
+    struct PendingRequest {
+        int socket;
+        std::string line;
+    };
+
+    SearchServer& search_server_;
+    QueryServiceOptions options_;
+    int listen_socket_ = -1;
+    int epoll_ = -1;
+    int wake_event_ = -1;
+    std::unordered_map<int, Connection> connections_;
+    std::vector<PendingRequest> pending_;
+    size_t pending_searches_ = 0;
+    std::chrono::steady_clock::time_point first_pending_time_;
+
+    void AcceptConnections();
+    void ReadConnection(int socket);
+    // Moves the complete lines of connection.input to pending_; input keeps the
+    // unterminated tail. scan_from skips bytes already known to hold no newline.
+    void QueueLines(int socket, Connection& connection, size_t scan_from);
+    void ProcessPending();
+    void FlushSearches(std::vector<PendingRequest>& searches);
+    std::string ExecuteCommand(std::string_view line);
+    void WriteConnection(int socket);
+    void CloseConnection(int socket);
+};
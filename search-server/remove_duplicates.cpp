@@ -2,15 +2,16 @@
 
 void RemoveDuplicates(SearchServer& search_server)
 {
-    std::map<std::set<std::string>, int> anti_duplicate_map;
+    std::map<std::vector<std::string_view>, int> anti_duplicate_map;
     std::set<int> anti_duplicate_id;
 
     for (const int id : search_server) {
-        std::map<std::string, double> word_frequencies_internal = search_server.GetWordFrequencies(id);
-        std::set<std::string> words_internal;
-        for (const auto& word : word_frequencies_internal) {
-            words_internal.insert(word.first);
+        // The views point into the server, which keeps every word it has seen.
+        std::vector<std::string_view> words_internal;
+        for (const auto& [word, _] : search_server.GetWordFrequencies(id)) {
+            words_internal.push_back(word);
         }
+        std::sort(words_internal.begin(), words_internal.end());
         if (anti_duplicate_map.count(words_internal) != 0) {
             int current_id = anti_duplicate_map.at(words_internal);
             anti_duplicate_id.insert(std::max(current_id, id));
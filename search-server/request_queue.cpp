@@ -1,7 +1,12 @@
 #include "request_queue.h"
 
 RequestQueue::RequestQueue(const SearchServer& search_server)
-	: search_server_request(search_server), no_result(0)
+	: RequestQueue(search_server, std::chrono::minutes(1), min_in_day_)
+{
+}
+
+RequestQueue::RequestQueue(const SearchServer& search_server, RequestStatistics::Clock::duration bucket_duration, size_t bucket_count)
+	: search_server_request(search_server), statistics_(bucket_duration, bucket_count)
 {
 }
 
@@ -19,5 +24,10 @@ std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query)
 
 int RequestQueue::GetNoResultRequests() const
 {
-	return no_result;
+	return static_cast<int>(statistics_.GetSnapshot(statistics_.GetMaxWindow()).no_result_requests);
+}
+
+RequestStatisticsSnapshot RequestQueue::GetStatistics(RequestStatistics::Clock::duration window) const
+{
+	return statistics_.GetSnapshot(window);
 }
\ No newline at end of file
@@ -1,12 +1,16 @@
 #pragma once
 
-#include <queue>
+#include <chrono>
+#include "request_statistics.h"
 #include "search_server.h"
 
 class RequestQueue {
 public:
     explicit RequestQueue(const SearchServer& search_server);
 
+    RequestQueue(const SearchServer& search_server, RequestStatistics::Clock::duration bucket_duration, size_t bucket_count);
+
+    // AddFindRequest may be called from several threads at once.
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
 
@@ -15,23 +19,19 @@ public:
     std::vector<Document> AddFindRequest(const std::string& raw_query);
 
     int GetNoResultRequests() const;
+
+    RequestStatisticsSnapshot GetStatistics(RequestStatistics::Clock::duration window) const;
 private:
-    std::deque<int> requests_;
     const static int min_in_day_ = 1440;
     const SearchServer& search_server_request;
-    int no_result;
+    RequestStatistics statistics_;
 };
 
 template <typename DocumentPredicate>
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
+    const auto start_time = RequestStatistics::Clock::now();
     const std::vector<Document> request_ = search_server_request.FindTopDocuments(raw_query, document_predicate);
-    if (request_.empty()) {
-        no_result++;
-    }
-    if (requests_.size() >= min_in_day_) {
-        requests_.pop_front();
-        no_result--;
-    }
-    requests_.push_front(static_cast<int>(request_.size()));
+    const auto end_time = RequestStatistics::Clock::now();
+    statistics_.Record(request_.size(), end_time - start_time, end_time);
     return request_;
-}
\ No newline at end of file
+}
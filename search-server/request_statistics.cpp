@@ -0,0 +1,97 @@
+#include "request_statistics.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+using namespace std::string_literals;
+
+std::chrono::microseconds RequestStatisticsSnapshot::GetLatencyPercentile(double fraction) const
+{
+    const double threshold = fraction * requests;
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKET_COUNT; ++i) {
+        seen += latencies[i];
+        if (seen > 0 && seen >= threshold) {
+            return std::chrono::microseconds(int64_t{ 1 } << (i + 1));
+        }
+    }
+    return std::chrono::microseconds(0);
+}
+
+RequestStatistics::RequestStatistics(Clock::duration bucket_duration, size_t bucket_count, size_t shard_count)
+    : bucket_duration_(bucket_duration)
+    , bucket_count_(bucket_count)
+    , shards_(shard_count)
+{
+    if (bucket_duration_.count() <= 0 || bucket_count_ == 0 || shard_count == 0) {
+        throw std::invalid_argument("Invalid request statistics window"s);
+    }
+    for (Shard& shard : shards_) {
+        shard.buckets.resize(bucket_count_);
+    }
+}
+
+void RequestStatistics::Record(size_t result_size, Clock::duration latency, Clock::time_point now)
+{
+    const int64_t tick = GetTick(now);
+    const auto latency_us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    int latency_bucket = 0;
+    while (latency_bucket + 1 < LATENCY_BUCKET_COUNT && (int64_t{ 1 } << (latency_bucket + 1)) <= latency_us) {
+        ++latency_bucket;
+    }
+
+    Shard& shard = shards_[std::hash<std::thread::id>{}(std::this_thread::get_id()) % shards_.size()];
+    std::lock_guard guard(shard.mutex);
+
+    Bucket& bucket = shard.buckets[static_cast<size_t>(tick) % bucket_count_];
+    if (bucket.tick != tick) {
+        bucket.tick = tick;
+        bucket.counters = {};
+    }
+
+    RequestStatisticsSnapshot& counters = bucket.counters;
+    ++counters.requests;
+    if (result_size == 0) {
+        ++counters.no_result_requests;
+    }
+    ++counters.result_sizes[std::min<size_t>(result_size, MAX_RESULT_DOCUMENT_COUNT)];
+    ++counters.latencies[latency_bucket];
+}
+
+RequestStatisticsSnapshot RequestStatistics::GetSnapshot(Clock::duration window, Clock::time_point now) const
+{
+    const int64_t current_tick = GetTick(now);
+    const int64_t window_buckets = std::clamp<int64_t>((window + bucket_duration_ - Clock::duration(1)) / bucket_duration_,
+        1, static_cast<int64_t>(bucket_count_));
+
+    RequestStatisticsSnapshot snapshot;
+    for (Shard& shard : shards_) {
+        std::lock_guard guard(shard.mutex);
+        for (const Bucket& bucket : shard.buckets) {
+            if (bucket.tick > current_tick - window_buckets && bucket.tick <= current_tick) {
+                const RequestStatisticsSnapshot& counters = bucket.counters;
+                snapshot.requests += counters.requests;
+                snapshot.no_result_requests += counters.no_result_requests;
+                for (size_t i = 0; i < snapshot.result_sizes.size(); ++i) {
+                    snapshot.result_sizes[i] += counters.result_sizes[i];
+                }
+                for (size_t i = 0; i < snapshot.latencies.size(); ++i) {
+                    snapshot.latencies[i] += counters.latencies[i];
+                }
+            }
+        }
+    }
+    return snapshot;
+}
+
+RequestStatistics::Clock::duration RequestStatistics::GetMaxWindow() const
+{
+    return bucket_duration_ * static_cast<int64_t>(bucket_count_);
+}
+
+int64_t RequestStatistics::GetTick(Clock::time_point time) const
+{
+    return time.time_since_epoch() / bucket_duration_;
+}
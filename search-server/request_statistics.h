@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "search_server.h"
+
+const int LATENCY_BUCKET_COUNT = 32;
+
+struct RequestStatisticsSnapshot {
+    uint64_t requests = 0;
+    uint64_t no_result_requests = 0;
+    // Index is the number of returned documents.
+    std::array<uint64_t, MAX_RESULT_DOCUMENT_COUNT + 1> result_sizes{};
+    // Bucket i counts requests that took [2^i, 2^(i+1)) microseconds, bucket 0 also takes anything faster.
+    std::array<uint64_t, LATENCY_BUCKET_COUNT> latencies{};
+
+    // Upper bound of the latency bucket containing the requested fraction of requests.
+    std::chrono::microseconds GetLatencyPercentile(double fraction) const;
+};
+
+// Time-bucketed ring of request counters. Writers are spread over shards picked by
+// thread id, so concurrent callers rarely contend for the same mutex; readers merge
+// all shards.
+class RequestStatistics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    RequestStatistics(Clock::duration bucket_duration, size_t bucket_count, size_t shard_count = 16);
+
+    void Record(size_t result_size, Clock::duration latency, Clock::time_point now = Clock::now());
+
+    // The window is rounded up to whole buckets and capped at GetMaxWindow().
+    RequestStatisticsSnapshot GetSnapshot(Clock::duration window, Clock::time_point now = Clock::now()) const;
+
+    Clock::duration GetMaxWindow() const;
+
+private:
+    struct Bucket {
+        int64_t tick = -1;
+        RequestStatisticsSnapshot counters;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::vector<Bucket> buckets;
+    };
+
+    Clock::duration bucket_duration_;
+    size_t bucket_count_;
+    mutable std::vector<Shard> shards_;
+
+    int64_t GetTick(Clock::time_point time) const;
+};
@@ -0,0 +1,25 @@
+#include "scratch_arena.h"
+
+ScratchArena::ScratchArena()
+    : state_(GetThreadState())
+{
+    ++state_.depth;
+}
+
+ScratchArena::~ScratchArena()
+{
+    if (--state_.depth == 0) {
+        state_.resource.release();
+    }
+}
+
+std::pmr::memory_resource* ScratchArena::GetResource() const
+{
+    return &state_.resource;
+}
+
+ScratchArena::ThreadState& ScratchArena::GetThreadState()
+{
+    thread_local ThreadState state;
+    return state;
+}
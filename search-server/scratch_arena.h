@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+// Per-thread monotonic arena for memory that lives only while a query runs.
+// Arenas nest: the memory is released when the outermost ScratchArena on the
+// thread is destroyed, so nothing allocated from it may escape that scope.
+class ScratchArena {
+public:
+    ScratchArena();
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    ~ScratchArena();
+
+    std::pmr::memory_resource* GetResource() const;
+
+private:
+    static const size_t INITIAL_BUFFER_SIZE = 64 * 1024;
+
+    struct ThreadState {
+        alignas(std::max_align_t) std::byte buffer[INITIAL_BUFFER_SIZE];
+        std::pmr::monotonic_buffer_resource resource{ buffer, INITIAL_BUFFER_SIZE, std::pmr::new_delete_resource() };
+        int depth = 0;
+    };
+
+    ThreadState& state_;
+
+    static ThreadState& GetThreadState();
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "document.h"
+
+const double MAX_DIFFERENCE = 1e-6;
+
+// Relevance rounded to a multiple of MAX_DIFFERENCE. Comparing the rounded
+// values instead of |lhs - rhs| < MAX_DIFFERENCE keeps "equal relevance"
+// transitive, which sorting, heaps and cursors all depend on.
+inline long long GetRelevanceKey(double relevance) {
+    return std::llround(relevance / MAX_DIFFERENCE);
+}
+
+// Ranking order of search results: relevance, then rating, then id, so that
+// every document has a single position a cursor can point to. This is a
+// strict total order on distinct ids.
+inline bool IsRankedBefore(const Document& lhs, const Document& rhs) {
+    const long long lhs_key = GetRelevanceKey(lhs.relevance);
+    const long long rhs_key = GetRelevanceKey(rhs.relevance);
+    if (lhs_key != rhs_key) {
+        return lhs_key > rhs_key;
+    }
+    if (lhs.rating != rhs.rating) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.id < rhs.id;
+}
+
+// Position after the last document of a page. A default-constructed cursor
+// starts at the top of the results.
+class SearchCursor {
+public:
+    SearchCursor() = default;
+
+    bool IsEnd() const {
+        return state_ == State::END;
+    }
+
+    // True if the document comes after the cursor position.
+    bool Admits(const Document& document) const {
+        return state_ == State::START || (state_ == State::AFTER && IsRankedBefore(last_, document));
+    }
+
+    static SearchCursor After(const Document& document) {
+        SearchCursor cursor;
+        cursor.state_ = State::AFTER;
+        cursor.last_ = document;
+        return cursor;
+    }
+
+    static SearchCursor End() {
+        SearchCursor cursor;
+        cursor.state_ = State::END;
+        return cursor;
+    }
+
+private:
+    enum class State {
+        START,
+        AFTER,
+        END,
+    };
+
+    State state_ = State::START;
+    Document last_;
+};
+
+struct DocumentPage {
+    std::vector<Document> documents;
+    SearchCursor next;
+};
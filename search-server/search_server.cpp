@@ -7,25 +7,140 @@ SearchServer::SearchServer(std::string_view stop_words_text) : SearchServer(Spli
 void SearchServer::AddDocument(int document_id, std::string_view document,
 	DocumentStatus status, const std::vector<int>& ratings)
 {
+	METRICS_SCOPED_TIMER(MetricTimer::ADD_DOCUMENT);
 	if ((document_id < 0) || (documents_.count(document_id) > 0)) {
 		throw std::invalid_argument("Invalid document_id"s);
 	}
+	DropImpactIndex();
 	
-	const auto words = SplitIntoWordsNoStop(document);
+	ScratchArena scratch;
+	const auto words = SplitIntoWordsNoStop(document, scratch.GetResource());
 	
 	const double inv_word_count = 1.0 / words.size();
+	std::pmr::vector<uint32_t> term_ids(scratch.GetResource());
+	term_ids.reserve(words.size());
 	for (std::string_view word : words) {
-		auto extra_word = storage.insert(std::string(word));
+		const uint32_t term_id = GetTermId(word);
+		term_ids.push_back(term_id);
+		word_to_document_freqs_[term_words_[term_id]][document_id] += inv_word_count;
+	}
 
-		word_to_document_freqs_[*extra_word.first][document_id] += inv_word_count;
-		word_frequencies_[document_id][*extra_word.first] += inv_word_count;
+	DocumentData document_data{ ComputeAverageRating(ratings), status, static_cast<uint32_t>(words.size()),
+		std::pmr::vector<uint8_t>(index_resource_.get()) };
+	if (forward_index_encoding_ != ForwardIndexEncoding::DISABLED) {
+		std::sort(term_ids.begin(), term_ids.end());
+		std::vector<std::pair<uint32_t, uint32_t>> term_counts;
+		for (uint32_t term_id : term_ids) {
+			if (term_counts.empty() || term_counts.back().first != term_id) {
+				term_counts.emplace_back(term_id, 0);
+			}
+			++term_counts.back().second;
+		}
+		EncodeTermCounts(forward_index_encoding_, term_counts, document_data.terms);
 	}
-	
-	documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
+	documents_.emplace(document_id, std::move(document_data));
 
 	document_ids_.insert(document_id);
 }
 
+uint32_t SearchServer::GetTermId(std::string_view word)
+{
+	auto stored_word = storage.find(word);
+	if (stored_word == storage.end()) {
+		stored_word = storage.emplace(word, static_cast<uint32_t>(term_words_.size())).first;
+		term_words_.push_back(stored_word->first);
+	}
+	return stored_word->second;
+}
+
+void SearchServer::RestoreDocument(int document_id, DocumentStatus status, int rating, uint32_t word_count)
+{
+	if ((document_id < 0) || (documents_.count(document_id) > 0)) {
+		throw std::invalid_argument("Invalid document_id"s);
+	}
+	DropImpactIndex();
+	documents_.emplace_hint(documents_.end(), document_id,
+		DocumentData{ rating, status, word_count, std::pmr::vector<uint8_t>(index_resource_.get()) });
+	document_ids_.insert(document_ids_.end(), document_id);
+}
+
+void SearchServer::RestoreWord(std::string_view word, const std::vector<std::pair<int, double>>& postings)
+{
+	const std::string_view stored_word = term_words_[GetTermId(word)];
+	auto& document_freqs = word_to_document_freqs_.emplace_hint(word_to_document_freqs_.end(),
+		stored_word, std::pmr::map<int, double>{ index_resource_.get() })->second;
+	for (const auto& [document_id, term_freq] : postings) {
+		if (documents_.count(document_id) == 0) {
+			throw std::invalid_argument("Invalid document_id"s);
+		}
+		document_freqs.emplace_hint(document_freqs.end(), document_id, term_freq);
+	}
+}
+
+SearchServer::StoredDocument SearchServer::GetStoredDocument(int document_id) const
+{
+	const DocumentData& document_data = documents_.at(document_id);
+	StoredDocument document{ document_id, document_data.status, document_data.rating, document_data.word_count, {} };
+	for (const auto& word_frequency : GetWordFrequencies(document_id)) {
+		document.word_frequencies.push_back(word_frequency);
+	}
+	return document;
+}
+
+void SearchServer::RestoreStoredDocument(const StoredDocument& document)
+{
+	if ((document.document_id < 0) || (documents_.count(document.document_id) > 0)) {
+		throw std::invalid_argument("Invalid document_id"s);
+	}
+	DropImpactIndex();
+
+	std::vector<std::pair<uint32_t, uint32_t>> term_counts;
+	for (const auto& [word, term_freq] : document.word_frequencies) {
+		const uint32_t term_id = GetTermId(word);
+		word_to_document_freqs_[term_words_[term_id]][document.document_id] = term_freq;
+		term_counts.emplace_back(term_id, static_cast<uint32_t>(std::lround(term_freq * document.word_count)));
+	}
+	std::sort(term_counts.begin(), term_counts.end());
+
+	DocumentData document_data{ document.rating, document.status, document.word_count,
+		std::pmr::vector<uint8_t>(index_resource_.get()) };
+	EncodeTermCounts(forward_index_encoding_, term_counts, document_data.terms);
+	documents_.emplace(document.document_id, std::move(document_data));
+
+	document_ids_.insert(document.document_id);
+}
+
+void SearchServer::RebuildForwardIndex()
+{
+	std::map<int, std::vector<std::pair<uint32_t, uint32_t>>> document_term_counts;
+	if (forward_index_encoding_ != ForwardIndexEncoding::DISABLED) {
+		for (const auto& [word, document_freqs] : word_to_document_freqs_) {
+			const uint32_t term_id = storage.find(word)->second;
+			for (const auto& [document_id, term_freq] : document_freqs) {
+				const uint32_t word_count = documents_.at(document_id).word_count;
+				document_term_counts[document_id].emplace_back(term_id,
+					static_cast<uint32_t>(std::lround(term_freq * word_count)));
+			}
+		}
+	}
+	for (auto& [document_id, document_data] : documents_) {
+		auto& term_counts = document_term_counts[document_id];
+		std::sort(term_counts.begin(), term_counts.end());
+		EncodeTermCounts(forward_index_encoding_, term_counts, document_data.terms);
+	}
+}
+
+void SearchServer::SetForwardIndexEncoding(ForwardIndexEncoding encoding)
+{
+	forward_index_encoding_ = encoding;
+	RebuildForwardIndex();
+}
+
+ForwardIndexEncoding SearchServer::GetForwardIndexEncoding() const
+{
+	return forward_index_encoding_;
+}
+
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const
 {
 	return FindTopDocuments(
@@ -39,6 +154,33 @@ std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query)
 	return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
 
+DocumentPage SearchServer::FindTopDocuments(std::string_view raw_query, const SearchCursor& cursor, size_t page_size,
+	DocumentStatus status) const
+{
+	return FindTopDocuments(
+		raw_query, cursor, page_size, [status](int document_id, DocumentStatus document_status, int rating) {
+			return document_status == status;
+		});
+}
+
+DocumentPage SearchServer::FindTopDocuments(std::string_view raw_query, const SearchCursor& cursor, size_t page_size) const
+{
+	return FindTopDocuments(raw_query, cursor, page_size, DocumentStatus::ACTUAL);
+}
+
+PartialResult SearchServer::FindTopDocuments(std::string_view raw_query, const QueryBudget& budget, DocumentStatus status) const
+{
+	return FindTopDocuments(
+		raw_query, budget, [status](int document_id, DocumentStatus document_status, int rating) {
+			return document_status == status;
+		});
+}
+
+PartialResult SearchServer::FindTopDocuments(std::string_view raw_query, const QueryBudget& budget) const
+{
+	return FindTopDocuments(raw_query, budget, DocumentStatus::ACTUAL);
+}
+
 int SearchServer::GetDocumentCount() const
 {
 	return documents_.size();
@@ -54,50 +196,97 @@ typename std::set<int>::const_iterator SearchServer::end() const
 	return SearchServer::document_ids_.end();
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const
+WordFrequencies SearchServer::GetWordFrequencies(int document_id) const
 {
-	if (word_frequencies_.count(document_id) != 0) {
-		return word_frequencies_.at(document_id);
+	const auto document = documents_.find(document_id);
+	if (document == documents_.end()) {
+		return {};
 	}
-	else {
-		static const std::map<std::string_view, double> empty;
-		return empty;
+	const DocumentData& document_data = document->second;
+	if (forward_index_encoding_ != ForwardIndexEncoding::DISABLED) {
+		return { forward_index_encoding_, document_data.terms.data(),
+			document_data.terms.data() + document_data.terms.size(), document_data.word_count, &term_words_ };
 	}
+
+	std::vector<std::pair<uint32_t, uint32_t>> term_counts;
+	for (const auto& [word, document_freqs] : word_to_document_freqs_) {
+		const auto term_freq = document_freqs.find(document_id);
+		if (term_freq != document_freqs.end()) {
+			term_counts.emplace_back(storage.find(word)->second,
+				static_cast<uint32_t>(std::lround(term_freq->second * document_data.word_count)));
+		}
+	}
+	std::sort(term_counts.begin(), term_counts.end());
+	auto terms = std::make_shared<std::pmr::vector<uint8_t>>();
+	EncodeTermCounts(ForwardIndexEncoding::PLAIN, term_counts, *terms);
+	const uint8_t* const begin = terms->data();
+	const uint8_t* const end = begin + terms->size();
+	return { ForwardIndexEncoding::PLAIN, begin, end, document_data.word_count, &term_words_, std::move(terms) };
 }
 
 void SearchServer::RemoveDocument(int document_id)
 {
-	if (documents_.count(document_id) == 0) {
+	METRICS_SCOPED_TIMER(MetricTimer::REMOVE_DOCUMENT);
+	const auto document = documents_.find(document_id);
+	if (document == documents_.end()) {
 		return;
 	}
-
-	for (auto& word_to_delete : word_frequencies_.at(document_id)) {
-		auto itr = word_to_document_freqs_.find(word_to_delete.first);
-		itr->second.erase(document_id);
+	DropImpactIndex();
+
+	if (forward_index_encoding_ != ForwardIndexEncoding::DISABLED) {
+		const DocumentData& document_data = document->second;
+		TermCountReader reader(forward_index_encoding_, document_data.terms.data(),
+			document_data.terms.data() + document_data.terms.size());
+		uint32_t term_id = 0;
+		uint32_t count = 0;
+		while (reader.Next(term_id, count)) {
+			word_to_document_freqs_.find(term_words_[term_id])->second.erase(document_id);
+		}
+	}
+	else {
+		for (auto& [_, document_freqs] : word_to_document_freqs_) {
+			document_freqs.erase(document_id);
+		}
 	}
 
 	document_ids_.erase(document_id);
-	documents_.erase(document_id);
-	word_frequencies_.erase(document_id);
+	documents_.erase(document);
 }
 
 void SearchServer::RemoveDocument(const std::execution::parallel_policy& p_p, int document_id) {
-	if (documents_.count(document_id) == 0) {
+	METRICS_SCOPED_TIMER(MetricTimer::REMOVE_DOCUMENT);
+	const auto document = documents_.find(document_id);
+	if (document == documents_.end()) {
 		return;
 	}
+	DropImpactIndex();
+
+	// Each word's posting map is touched by one task only, so they can be
+	// erased from concurrently; looking them up stays sequential.
+	ScratchArena scratch;
+	std::pmr::vector<std::pmr::map<int, double>*> document_freqs_to_update(scratch.GetResource());
+	if (forward_index_encoding_ != ForwardIndexEncoding::DISABLED) {
+		const DocumentData& document_data = document->second;
+		TermCountReader reader(forward_index_encoding_, document_data.terms.data(),
+			document_data.terms.data() + document_data.terms.size());
+		uint32_t term_id = 0;
+		uint32_t count = 0;
+		while (reader.Next(term_id, count)) {
+			document_freqs_to_update.push_back(&word_to_document_freqs_.find(term_words_[term_id])->second);
+		}
+	}
+	else {
+		document_freqs_to_update.reserve(word_to_document_freqs_.size());
+		for (auto& [_, document_freqs] : word_to_document_freqs_) {
+			document_freqs_to_update.push_back(&document_freqs);
+		}
+	}
 
-	const auto& words_to_delete = word_frequencies_.at(document_id);
-	std::vector<std::string_view> words_to_delete_freqs(words_to_delete.size());
-
-	std::transform(p_p, words_to_delete.begin(), words_to_delete.end(), words_to_delete_freqs.begin(),
-		[](auto& ptr) { return ptr.first; });
-
-	std::for_each(std::execution::par, words_to_delete_freqs.begin(), words_to_delete_freqs.end(),
-		[this, &document_id](auto& word) { word_to_document_freqs_.find(word)->second.erase(document_id); });
+	std::for_each(p_p, document_freqs_to_update.begin(), document_freqs_to_update.end(),
+		[document_id](std::pmr::map<int, double>* document_freqs) { document_freqs->erase(document_id); });
 
 	document_ids_.erase(document_id);
-	documents_.erase(document_id);
-	word_frequencies_.erase(document_id);
+	documents_.erase(document);
 }
 
 void SearchServer::RemoveDocument(const std::execution::sequenced_policy& s_p, int document_id) {
@@ -106,6 +295,7 @@ void SearchServer::RemoveDocument(const std::execution::sequenced_policy& s_p, i
 
 matched_documents SearchServer::MatchDocument(std::string_view raw_query, int document_id) const
 {
+	METRICS_SCOPED_TIMER(MetricTimer::MATCH_DOCUMENT);
 	if (documents_.count(document_id) == 0) {
 		throw std::out_of_range("Nonexistent document id");
 	}
@@ -113,7 +303,8 @@ matched_documents SearchServer::MatchDocument(std::string_view raw_query, int do
 		throw std::invalid_argument("Invalid raw query");
 	}
 
-	const auto query = ParseQuery(raw_query);
+	ScratchArena scratch;
+	const auto query = ParseQuery(raw_query, scratch.GetResource());
 
 	std::vector<std::string_view> matched_words;
 
@@ -122,7 +313,7 @@ matched_documents SearchServer::MatchDocument(std::string_view raw_query, int do
 			continue;
 		}
 		if (word_to_document_freqs_.find(word)->second.count(document_id)) {
-			return { {}, documents_.at(document_id).status };;
+			return { std::vector<std::string_view>{}, documents_.at(document_id).status };
 		}
 	}
 
@@ -140,6 +331,7 @@ matched_documents SearchServer::MatchDocument(std::string_view raw_query, int do
 
 matched_documents SearchServer::MatchDocument(const std::execution::parallel_policy& p_p,
 	std::string_view raw_query, int document_id) const {
+	METRICS_SCOPED_TIMER(MetricTimer::MATCH_DOCUMENT);
 	if (documents_.count(document_id) == 0) {
 		throw std::out_of_range("Nonexistent document id");
 	}
@@ -147,17 +339,23 @@ matched_documents SearchServer::MatchDocument(const std::execution::parallel_pol
 		throw std::invalid_argument("Invalid raw query");
 	}
 
-	const auto& result = ParseQuery(raw_query, false);
+	ScratchArena scratch;
+	const auto& result = ParseQuery(raw_query, scratch.GetResource(), false);
 
 	std::vector<std::string_view> matched_words(result.plus_words.size());
 
-	if (std::any_of(std::execution::par, result.minus_words.begin(), result.minus_words.end(), [this, &document_id](std::string_view word)
-		{ return word_to_document_freqs_.find(word)->second.count(document_id) != 0; })) {
-		return { {}, documents_.at(document_id).status };;
+	if (std::any_of(std::execution::par, result.minus_words.begin(), result.minus_words.end(), [this, &document_id](std::string_view word) {
+			const auto word_freqs = word_to_document_freqs_.find(word);
+			return word_freqs != word_to_document_freqs_.end() && word_freqs->second.count(document_id) != 0;
+		})) {
+		return { std::vector<std::string_view>{}, documents_.at(document_id).status };
 	}
 
 	auto last_ptr = std::copy_if(std::execution::par, result.plus_words.begin(), result.plus_words.end(), matched_words.begin(),
-		[this, &document_id](std::string_view word) { return word_to_document_freqs_.find(word)->second.count(document_id) != 0; });
+		[this, &document_id](std::string_view word) {
+			const auto word_freqs = word_to_document_freqs_.find(word);
+			return word_freqs != word_to_document_freqs_.end() && word_freqs->second.count(document_id) != 0;
+		});
 
 	std::sort(std::execution::par, matched_words.begin(), last_ptr);
 	last_ptr = std::unique(std::execution::par, matched_words.begin(), last_ptr);
@@ -171,6 +369,82 @@ matched_documents SearchServer::MatchDocument(const std::execution::sequenced_po
 	return MatchDocument(raw_query, document_id);
 }
 
+void SearchServer::SetTermStatistics(const TermStatistics* term_statistics)
+{
+	term_statistics_ = term_statistics;
+}
+
+void SearchServer::BuildImpactIndex(ImpactEncoding encoding)
+{
+	BuildImpactIndex(encoding, std::vector<int>(document_ids_.begin(), document_ids_.end()));
+}
+
+void SearchServer::BuildImpactIndex(ImpactEncoding encoding, const std::vector<int>& document_order)
+{
+	if (document_order.size() != document_ids_.size()) {
+		throw std::invalid_argument("Document order must list every document once"s);
+	}
+	std::vector<std::pair<int, uint32_t>> document_id_to_ordinal;
+	document_id_to_ordinal.reserve(document_order.size());
+	for (size_t ordinal = 0; ordinal < document_order.size(); ++ordinal) {
+		document_id_to_ordinal.emplace_back(document_order[ordinal], static_cast<uint32_t>(ordinal));
+	}
+	std::sort(document_id_to_ordinal.begin(), document_id_to_ordinal.end());
+	const bool is_permutation = std::equal(document_ids_.begin(), document_ids_.end(), document_id_to_ordinal.begin(),
+		[](int document_id, const std::pair<int, uint32_t>& entry) { return document_id == entry.first; });
+	if (!is_permutation) {
+		throw std::invalid_argument("Document order must list every document once"s);
+	}
+
+	auto impact_index = std::make_unique<ImpactIndex>(encoding);
+	std::vector<const DocumentData*> ordinal_documents;
+	ordinal_documents.reserve(document_order.size());
+	for (int document_id : document_order) {
+		ordinal_documents.push_back(&documents_.at(document_id));
+	}
+
+	std::vector<std::pair<uint32_t, double>> ordinal_impacts;
+	for (const auto& [word, document_freqs] : word_to_document_freqs_) {
+		if (document_freqs.empty()) {
+			continue;
+		}
+		const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
+		ordinal_impacts.clear();
+		// Both sides are sorted by document id, so one merge pass finds every ordinal.
+		auto entry = document_id_to_ordinal.begin();
+		for (const auto& [document_id, term_freq] : document_freqs) {
+			while (entry->first < document_id) {
+				++entry;
+			}
+			ordinal_impacts.emplace_back(entry->second, term_freq * inverse_document_freq);
+		}
+		impact_index->AddPostings(word, ordinal_impacts);
+	}
+
+	impact_index_ = std::move(impact_index);
+	ordinal_to_document_id_ = document_order;
+	ordinal_documents_ = std::move(ordinal_documents);
+}
+
+bool SearchServer::HasImpactIndex() const
+{
+	return impact_index_ != nullptr;
+}
+
+const ImpactIndex* SearchServer::GetImpactIndex() const
+{
+	return impact_index_.get();
+}
+
+void SearchServer::DropImpactIndex()
+{
+	if (impact_index_ != nullptr) {
+		impact_index_.reset();
+		ordinal_to_document_id_.clear();
+		ordinal_documents_.clear();
+	}
+}
+
 bool SearchServer::IsStopWord(std::string_view word) const
 {
 	return stop_words_.count(word) > 0;
@@ -182,10 +456,10 @@ bool SearchServer::IsValidWord(std::string_view word) {
 		});
 }
 
-std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const
+std::pmr::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text, std::pmr::memory_resource* resource) const
 {
-	std::vector<std::string_view> words;
-	for (std::string_view word : SplitIntoWords(text)) {
+	std::pmr::vector<std::string_view> words(resource);
+	for (std::string_view word : SplitIntoWords(text, resource)) {
 		if (!IsValidWord(word)) {
 			throw std::invalid_argument("Word "s + std::string(word) + " is invalid"s);
 		}
@@ -226,11 +500,11 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
 	return { word, is_minus, IsStopWord(word) };
 }
 
-SearchServer::Query SearchServer::ParseQuery(std::string_view text, bool seq) const
+SearchServer::Query SearchServer::ParseQuery(std::string_view text, std::pmr::memory_resource* resource, bool seq) const
 {
-	Query result;
+	Query result{ std::pmr::vector<std::string_view>(resource), std::pmr::vector<std::string_view>(resource) };
 
-	for (std::string_view word : SplitIntoWords(text)) {
+	for (std::string_view word : SplitIntoWords(text, resource)) {
 		const auto query_word = ParseQueryWord(word);
 		if (!query_word.is_stop) {
 			if (query_word.is_minus) {
@@ -263,5 +537,11 @@ SearchServer::Query SearchServer::ParseQuery(std::string_view text, bool seq) co
 }
 
 double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const {
+	if (term_statistics_ != nullptr) {
+		const int word_document_count = term_statistics_->GetWordDocumentCount(word);
+		if (word_document_count > 0) {
+			return log(term_statistics_->GetDocumentCount() * 1.0 / word_document_count);
+		}
+	}
 	return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.find(word)->second.size());
 }
\ No newline at end of file
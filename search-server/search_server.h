@@ -4,20 +4,32 @@
 #include <set>
 #include <stdexcept>
 #include <algorithm>
+#include <cfloat>
 #include <cmath>
 #include <execution>
+#include <memory>
+#include <memory_resource>
 #include <string_view>
 
 #include "document.h"
+#include "search_cursor.h"
 #include "string_processing.h"
 #include "concurrent_map.h"
+#include "forward_index.h"
+#include "impact_index.h"
+#include "metrics.h"
+#include "query_budget.h"
+#include "scratch_arena.h"
+#include "term_statistics.h"
 
 using namespace std::string_literals;
 
 using matched_documents = std::tuple<std::vector<std::string_view>, DocumentStatus>;
 
-const double MAX_DIFFERENCE = 1e-6;
+struct IndexSnapshot;
+
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
+const size_t POSTING_BLOCK_SIZE = 256;
 
 class SearchServer {
 public:
@@ -28,6 +40,13 @@ public:
 
     explicit SearchServer(std::string_view stop_words_text);
 
+    // The index containers allocate from index_resource_, so a server can be
+    // moved but not copied or assigned.
+    SearchServer(SearchServer&&) = default;
+    SearchServer(const SearchServer&) = delete;
+    SearchServer& operator=(const SearchServer&) = delete;
+    SearchServer& operator=(SearchServer&&) = delete;
+
     void AddDocument(int document_id, std::string_view document, DocumentStatus status,
         const std::vector<int>& ratings);
 
@@ -43,13 +62,31 @@ public:
     template <typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query) const;
 
+    // Returns up to page_size documents ranked after the cursor and the cursor for the
+    // next page. Only the page is kept while scoring, in a heap of page_size documents.
+    template <typename DocumentPredicate>
+    DocumentPage FindTopDocuments(std::string_view raw_query, const SearchCursor& cursor, size_t page_size,
+        DocumentPredicate document_predicate) const;
+    DocumentPage FindTopDocuments(std::string_view raw_query, const SearchCursor& cursor, size_t page_size,
+        DocumentStatus status) const;
+    DocumentPage FindTopDocuments(std::string_view raw_query, const SearchCursor& cursor, size_t page_size) const;
+
+    // Stops scoring once the budget is exhausted and returns the best documents
+    // scored so far, flagged as truncated.
+    template <typename DocumentPredicate>
+    PartialResult FindTopDocuments(std::string_view raw_query, const QueryBudget& budget, DocumentPredicate document_predicate) const;
+    PartialResult FindTopDocuments(std::string_view raw_query, const QueryBudget& budget, DocumentStatus status) const;
+    PartialResult FindTopDocuments(std::string_view raw_query, const QueryBudget& budget) const;
+
     int GetDocumentCount() const;
 
     typename std::set<int>::const_iterator begin() const;
 
     typename std::set<int>::const_iterator end() const;
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    // Empty for unknown documents. Scans the inverted index when the forward
+    // index is disabled. See WordFrequencies for how long the view is valid.
+    WordFrequencies GetWordFrequencies(int document_id) const;
 
     void RemoveDocument(int document_id);
     void RemoveDocument(const std::execution::parallel_policy& p_p, int document_id);
@@ -61,27 +98,88 @@ public:
         std::string_view raw_query, int document_id) const;
     matched_documents MatchDocument(const std::execution::sequenced_policy& s_p, std::string_view raw_query, int document_id) const;
 
+    void SetTermStatistics(const TermStatistics* term_statistics);
+
+    // PLAIN by default. Re-encodes every document's forward index.
+    void SetForwardIndexEncoding(ForwardIndexEncoding encoding);
+
+    ForwardIndexEncoding GetForwardIndexEncoding() const;
+
+    // Precomputes every posting's tf-idf impact in the given encoding. While the
+    // impact index exists, sequential FindTopDocuments scores from it; any
+    // AddDocument or RemoveDocument drops it. Not used with TermStatistics.
+    void BuildImpactIndex(ImpactEncoding encoding);
+
+    // Same, with ordinals assigned in the given order instead of by document id,
+    // e.g. from ComputeMinHashOrder. Results still carry external document ids.
+    // Throws std::invalid_argument unless the order lists every document once.
+    void BuildImpactIndex(ImpactEncoding encoding, const std::vector<int>& document_order);
+
+    const ImpactIndex* GetImpactIndex() const;
+
+    bool HasImpactIndex() const;
+
 private:
+    friend void SaveSnapshot(const SearchServer& search_server, uint64_t lsn, const std::string& path);
+    friend IndexSnapshot LoadSnapshot(const std::string& path);
+    friend class DurableSearchServer;
+
     struct DocumentData {
         int rating;
         DocumentStatus status;
+        // Non-stop words in the document, repeats included.
+        uint32_t word_count = 0;
+        // (term id, count) pairs sorted by term id, encoded as forward_index_encoding_.
+        std::pmr::vector<uint8_t> terms;
     };
     std::set<std::string, std::less<>> stop_words_;
-    std::set<std::string, std::less<>> storage;
 
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
+    std::unique_ptr<std::pmr::synchronized_pool_resource> index_resource_ = std::make_unique<std::pmr::synchronized_pool_resource>();
+    // Every word ever indexed, mapped to its term id; term_words_ maps back.
+    std::pmr::map<std::pmr::string, uint32_t, std::less<>> storage{ index_resource_.get() };
+    std::pmr::vector<std::string_view> term_words_{ index_resource_.get() };
+    std::pmr::map<std::string_view, std::pmr::map<int, double>> word_to_document_freqs_{ index_resource_.get() };
+    std::pmr::map<int, DocumentData> documents_{ index_resource_.get() };
     std::set<int> document_ids_;
-    std::map<int, std::map<std::string_view, double>> word_frequencies_;
+    ForwardIndexEncoding forward_index_encoding_ = ForwardIndexEncoding::PLAIN;
+    const TermStatistics* term_statistics_ = nullptr;
+    std::unique_ptr<ImpactIndex> impact_index_;
+    std::vector<int> ordinal_to_document_id_;
+    std::vector<const DocumentData*> ordinal_documents_;
 
     bool IsStopWord(std::string_view word) const;
 
     static bool IsValidWord(std::string_view word);
 
-    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
+    std::pmr::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text, std::pmr::memory_resource* resource) const;
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
+    void DropImpactIndex();
+
+    uint32_t GetTermId(std::string_view word);
+
+    // Rebuilds every document's forward index from the inverted index.
+    void RebuildForwardIndex();
+
+    // Used by LoadSnapshot: documents first, then every word with its postings
+    // in document id order, words in sorted order, so each insertion appends.
+    // RebuildForwardIndex finishes the restore.
+    void RestoreDocument(int document_id, DocumentStatus status, int rating, uint32_t word_count);
+    void RestoreWord(std::string_view word, const std::vector<std::pair<int, double>>& postings);
+
+    // Everything RemoveDocument drops, so DurableSearchServer can undo a
+    // removal it failed to log. Words stay valid: storage never forgets one.
+    struct StoredDocument {
+        int document_id = 0;
+        DocumentStatus status = DocumentStatus::ACTUAL;
+        int rating = 0;
+        uint32_t word_count = 0;
+        std::vector<std::pair<std::string_view, double>> word_frequencies;
+    };
+    StoredDocument GetStoredDocument(int document_id) const;
+    void RestoreStoredDocument(const StoredDocument& document);
+
     struct QueryWord {
         std::string_view data;
         bool is_minus;
@@ -91,16 +189,24 @@ private:
     QueryWord ParseQueryWord(std::string_view text) const;
 
     struct Query {
-        std::vector<std::string_view> plus_words;
-        std::vector<std::string_view> minus_words;
+        std::pmr::vector<std::string_view> plus_words;
+        std::pmr::vector<std::string_view> minus_words;
     };
 
-    Query ParseQuery(std::string_view text, bool seq = true) const;
+    Query ParseQuery(std::string_view text, std::pmr::memory_resource* resource, bool seq = true) const;
 
     double ComputeWordInverseDocumentFreq(std::string_view word) const;
 
+    template <typename DocumentPredicate>
+    std::pmr::map<int, double> ComputeDocumentRelevance(const Query& query, DocumentPredicate document_predicate,
+        const QueryBudget* budget = nullptr, bool* truncated = nullptr) const;
+
     template <typename DocumentPredicate>
     std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
+    // Only the documents that may rank in the top MAX_RESULT_DOCUMENT_COUNT,
+    // rescored in double so they match FindAllDocuments exactly.
+    template <typename DocumentPredicate>
+    std::vector<Document> FindAllDocumentsByImpact(const Query& query, DocumentPredicate document_predicate) const;
     template <typename DocumentPredicate>
     std::vector<Document> FindAllDocuments(std::execution::sequenced_policy policy, const Query& query, DocumentPredicate document_predicate) const;
     template <typename DocumentPredicate>
@@ -118,18 +224,13 @@ SearchServer::SearchServer(const StringContainer& stop_words)
 
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
+    METRICS_SCOPED_TIMER(MetricTimer::FIND_TOP_DOCUMENTS);
+    METRICS_COUNT(MetricCounter::QUERIES, 1);
 
-    const auto query = ParseQuery(raw_query);
+    ScratchArena scratch;
+    const auto query = ParseQuery(raw_query, scratch.GetResource());
     auto matched_documents = FindAllDocuments(query, document_predicate);
-    std::sort(matched_documents.begin(), matched_documents.end(),
-        [](const Document& lhs, const Document& rhs) {
-            if (std::abs(lhs.relevance - rhs.relevance) < MAX_DIFFERENCE) {
-                return lhs.rating > rhs.rating;
-            }
-            else {
-                return lhs.relevance > rhs.relevance;
-            }
-        });
+    std::sort(matched_documents.begin(), matched_documents.end(), IsRankedBefore);
     if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
         matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
     }
@@ -138,20 +239,15 @@ std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query,
 
 template <typename ExecutionPolicy, typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
-    
-    const auto query = ParseQuery(raw_query);
+    METRICS_SCOPED_TIMER(MetricTimer::FIND_TOP_DOCUMENTS);
+    METRICS_COUNT(MetricCounter::QUERIES, 1);
+
+    ScratchArena scratch;
+    const auto query = ParseQuery(raw_query, scratch.GetResource());
     
     auto matched_documents = FindAllDocuments(policy, query, document_predicate);
 
-    std::sort(policy, matched_documents.begin(), matched_documents.end(),
-        [](const Document& lhs, const Document& rhs) {
-            if (std::abs(lhs.relevance - rhs.relevance) < MAX_DIFFERENCE) {
-                return lhs.rating > rhs.rating;
-            }
-            else {
-                return lhs.relevance > rhs.relevance;
-            }
-        });
+    std::sort(policy, matched_documents.begin(), matched_documents.end(), IsRankedBefore);
 
     if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
         matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
@@ -173,22 +269,126 @@ std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
+DocumentPage SearchServer::FindTopDocuments(std::string_view raw_query, const SearchCursor& cursor, size_t page_size,
+    DocumentPredicate document_predicate) const {
+    METRICS_SCOPED_TIMER(MetricTimer::FIND_TOP_DOCUMENTS);
+    METRICS_COUNT(MetricCounter::QUERIES, 1);
+
+    DocumentPage page;
+    if (cursor.IsEnd() || page_size == 0) {
+        page.next = cursor;
+        return page;
+    }
 
-    std::map<int, double> document_to_relevance;
+    ScratchArena scratch;
+    const auto query = ParseQuery(raw_query, scratch.GetResource());
+    const auto document_to_relevance = ComputeDocumentRelevance(query, document_predicate);
 
-    for (std::string_view word : query.plus_words) {
+    // Max-heap on rank: the front is the worst document kept so far.
+    std::vector<Document>& heap = page.documents;
+    heap.reserve(std::min(page_size, document_to_relevance.size()));
+    for (const auto& [document_id, relevance] : document_to_relevance) {
+        const Document document(document_id, relevance, documents_.at(document_id).rating);
+        if (!cursor.Admits(document)) {
+            continue;
+        }
+        if (heap.size() < page_size) {
+            heap.push_back(document);
+            std::push_heap(heap.begin(), heap.end(), IsRankedBefore);
+        }
+        else if (IsRankedBefore(document, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), IsRankedBefore);
+            heap.back() = document;
+            std::push_heap(heap.begin(), heap.end(), IsRankedBefore);
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end(), IsRankedBefore);
+
+    page.next = heap.size() < page_size ? SearchCursor::End() : SearchCursor::After(heap.back());
+    return page;
+}
+
+template <typename DocumentPredicate>
+PartialResult SearchServer::FindTopDocuments(std::string_view raw_query, const QueryBudget& budget, DocumentPredicate document_predicate) const {
+    METRICS_SCOPED_TIMER(MetricTimer::FIND_TOP_DOCUMENTS);
+    METRICS_COUNT(MetricCounter::QUERIES, 1);
+
+    PartialResult result;
+    ScratchArena scratch;
+    const auto query = ParseQuery(raw_query, scratch.GetResource());
+    const auto document_to_relevance = ComputeDocumentRelevance(query, document_predicate, &budget, &result.truncated);
+    if (result.truncated) {
+        METRICS_COUNT(MetricCounter::TRUNCATED_QUERIES, 1);
+    }
+
+    auto& matched_documents = result.documents;
+    matched_documents.reserve(document_to_relevance.size());
+    for (const auto& [document_id, relevance] : document_to_relevance) {
+        matched_documents.push_back(
+            { document_id, relevance, documents_.at(document_id).rating });
+    }
+    std::sort(matched_documents.begin(), matched_documents.end(), IsRankedBefore);
+    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    }
+    return result;
+}
+
+template <typename DocumentPredicate>
+std::pmr::map<int, double> SearchServer::ComputeDocumentRelevance(const Query& query, DocumentPredicate document_predicate,
+    const QueryBudget* budget, bool* truncated) const {
+
+    std::pmr::memory_resource* resource = query.plus_words.get_allocator().resource();
+    std::pmr::map<int, double> document_to_relevance(resource);
+
+    // Under a budget the rarest words are scored first, so a truncated
+    // result is built from the most selective terms.
+    const std::pmr::vector<std::string_view>* plus_words = &query.plus_words;
+    std::pmr::vector<std::string_view> ordered_plus_words(resource);
+    if (budget != nullptr) {
+        ordered_plus_words = query.plus_words;
+        std::sort(ordered_plus_words.begin(), ordered_plus_words.end(), [this](std::string_view lhs, std::string_view rhs) {
+            const auto lhs_freqs = word_to_document_freqs_.find(lhs);
+            const auto rhs_freqs = word_to_document_freqs_.find(rhs);
+            const size_t lhs_size = lhs_freqs == word_to_document_freqs_.end() ? 0 : lhs_freqs->second.size();
+            const size_t rhs_size = rhs_freqs == word_to_document_freqs_.end() ? 0 : rhs_freqs->second.size();
+            return lhs_size < rhs_size;
+        });
+        plus_words = &ordered_plus_words;
+    }
+
+    size_t block_postings = 0;
+    bool exhausted = false;
+    for (std::string_view word : *plus_words) {
         if (word_to_document_freqs_.count(word) == 0) {
             continue;
         }
         const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto& [document_id, term_freq] : word_to_document_freqs_.find(word)->second) {
+        const auto& postings = word_to_document_freqs_.find(word)->second;
+        METRICS_COUNT(MetricCounter::POSTINGS_SCANNED, postings.size());
+        for (const auto& [document_id, term_freq] : postings) {
+            if (budget != nullptr && ++block_postings == POSTING_BLOCK_SIZE) {
+                block_postings = 0;
+                if (budget->IsExhausted()) {
+                    exhausted = true;
+                    break;
+                }
+            }
             const auto& document_data = documents_.at(document_id);
             if (document_predicate(document_id, document_data.status, document_data.rating)) {
                 document_to_relevance[document_id] += term_freq * inverse_document_freq;
             }
         }
+        if (exhausted) {
+            break;
+        }
     }
+    if (truncated != nullptr) {
+        *truncated = exhausted;
+    }
+
+    // Minus words are applied even past the budget: a truncated result may be
+    // incomplete but never contains excluded documents.
 
     for (std::string_view word : query.minus_words) {
         if (word_to_document_freqs_.count(word) == 0) {
@@ -199,7 +399,22 @@ std::vector<Document> SearchServer::FindAllDocuments(const Query& query, Documen
         }
     }
 
+    METRICS_COUNT(MetricCounter::DOCUMENTS_SCORED, document_to_relevance.size());
+
+    return document_to_relevance;
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
+
+    if (impact_index_ != nullptr && term_statistics_ == nullptr) {
+        return FindAllDocumentsByImpact(query, document_predicate);
+    }
+
+    const auto document_to_relevance = ComputeDocumentRelevance(query, document_predicate);
+
     std::vector<Document> matched_documents;
+    matched_documents.reserve(document_to_relevance.size());
     for (const auto& [document_id, relevance] : document_to_relevance) {
         matched_documents.push_back(
             { document_id, relevance, documents_.at(document_id).rating });
@@ -207,6 +422,96 @@ std::vector<Document> SearchServer::FindAllDocuments(const Query& query, Documen
     return matched_documents;
 }
 
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindAllDocumentsByImpact(const Query& query, DocumentPredicate document_predicate) const {
+
+    std::pmr::memory_resource* resource = query.plus_words.get_allocator().resource();
+    const size_t document_count = ordinal_to_document_id_.size();
+    std::pmr::vector<float> scores(document_count, 0.0f, resource);
+    std::pmr::vector<uint8_t> matched(document_count, 0, resource);
+    std::pmr::vector<uint32_t> touched(resource);
+
+    // A float score is off by at most each word's impact error plus the
+    // rounding of every float addition, bounded via the largest possible sum.
+    double impact_error = 0.0;
+    double max_score = 0.0;
+    size_t scored_words = 0;
+    for (std::string_view word : query.plus_words) {
+        const ImpactPostings* postings = impact_index_->FindPostings(word);
+        if (postings == nullptr) {
+            continue;
+        }
+        METRICS_COUNT(MetricCounter::POSTINGS_SCANNED, postings->ordinals.size());
+        impact_index_->Accumulate(*postings, scores.data());
+        impact_error += impact_index_->GetImpactError(*postings);
+        max_score += postings->max_impact;
+        ++scored_words;
+        for (uint32_t ordinal : postings->ordinals) {
+            if (matched[ordinal] == 0) {
+                matched[ordinal] = 1;
+                touched.push_back(ordinal);
+            }
+        }
+    }
+    const double score_error = impact_error + scored_words * max_score * FLT_EPSILON;
+
+    for (std::string_view word : query.minus_words) {
+        if (const ImpactPostings* postings = impact_index_->FindPostings(word)) {
+            for (uint32_t ordinal : postings->ordinals) {
+                matched[ordinal] = 0;
+            }
+        }
+    }
+
+    std::pmr::vector<uint32_t> candidates(resource);
+    for (uint32_t ordinal : touched) {
+        const DocumentData& document_data = *ordinal_documents_[ordinal];
+        if (matched[ordinal] != 0
+            && document_predicate(ordinal_to_document_id_[ordinal], document_data.status, document_data.rating)) {
+            candidates.push_back(ordinal);
+        }
+    }
+
+    // A document can only reach the top if its exact relevance may round to
+    // the key of the K-th best lower bound or above.
+    if (candidates.size() > MAX_RESULT_DOCUMENT_COUNT) {
+        std::pmr::vector<float> candidate_scores(resource);
+        candidate_scores.reserve(candidates.size());
+        for (uint32_t ordinal : candidates) {
+            candidate_scores.push_back(scores[ordinal]);
+        }
+        const auto kth = candidate_scores.begin() + (MAX_RESULT_DOCUMENT_COUNT - 1);
+        std::nth_element(candidate_scores.begin(), kth, candidate_scores.end(), std::greater<float>());
+        const double threshold = *kth - 2.0 * score_error - MAX_DIFFERENCE;
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+            [&scores, threshold](uint32_t ordinal) { return scores[ordinal] < threshold; }), candidates.end());
+    }
+
+    // Summed in query word order from zero, like ComputeDocumentRelevance.
+    std::pmr::vector<std::pair<const std::pmr::map<int, double>*, double>> word_postings(resource);
+    for (std::string_view word : query.plus_words) {
+        const auto document_freqs = word_to_document_freqs_.find(word);
+        if (document_freqs != word_to_document_freqs_.end() && !document_freqs->second.empty()) {
+            word_postings.emplace_back(&document_freqs->second, ComputeWordInverseDocumentFreq(word));
+        }
+    }
+    std::vector<Document> matched_documents;
+    matched_documents.reserve(candidates.size());
+    for (uint32_t ordinal : candidates) {
+        const int document_id = ordinal_to_document_id_[ordinal];
+        double relevance = 0.0;
+        for (const auto& [document_freqs, inverse_document_freq] : word_postings) {
+            const auto term_freq = document_freqs->find(document_id);
+            if (term_freq != document_freqs->end()) {
+                relevance += term_freq->second * inverse_document_freq;
+            }
+        }
+        matched_documents.push_back({ document_id, relevance, ordinal_documents_[ordinal]->rating });
+    }
+    METRICS_COUNT(MetricCounter::DOCUMENTS_SCORED, matched_documents.size());
+    return matched_documents;
+}
+
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindAllDocuments(std::execution::sequenced_policy policy, const Query& query, DocumentPredicate document_predicate) const {
     return FindAllDocuments(query, document_predicate);
@@ -214,13 +519,16 @@ std::vector<Document> SearchServer::FindAllDocuments(std::execution::sequenced_p
 
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindAllDocuments(std::execution::parallel_policy policy, const Query& query, DocumentPredicate document_predicate) const {
+    std::pmr::memory_resource* resource = query.plus_words.get_allocator().resource();
     const int concurrent_map_size = 100;
-    ConcurrentMap<int, double> document_to_relevance_help(concurrent_map_size);
+    ConcurrentMap<int, double> document_to_relevance_help(concurrent_map_size, resource);
 
     std::for_each(policy, query.plus_words.begin(), query.plus_words.end(), [this, &document_to_relevance_help, &document_predicate](std::string_view word) {
             if (word_to_document_freqs_.count(word) != 0) {
                 const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                for (const auto& [document_id, term_freq] : word_to_document_freqs_.find(word)->second) {
+                const auto& postings = word_to_document_freqs_.find(word)->second;
+                METRICS_COUNT(MetricCounter::POSTINGS_SCANNED, postings.size());
+                for (const auto& [document_id, term_freq] : postings) {
                     const auto& document_data = documents_.at(document_id);
                     if (document_predicate(document_id, document_data.status, document_data.rating)) {
                         document_to_relevance_help[document_id].ref_to_value += term_freq * inverse_document_freq;
@@ -237,9 +545,12 @@ std::vector<Document> SearchServer::FindAllDocuments(std::execution::parallel_po
             }
         });
 
-    auto document_to_relevance = document_to_relevance_help.BuildOrdinaryMap();
+    auto document_to_relevance = document_to_relevance_help.BuildOrdinaryMap(resource);
+
+    METRICS_COUNT(MetricCounter::DOCUMENTS_SCORED, document_to_relevance.size());
 
     std::vector<Document> matched_documents;
+    matched_documents.reserve(document_to_relevance.size());
     for (const auto& [document_id, relevance] : document_to_relevance) {
         matched_documents.push_back(
             { document_id, relevance, documents_.at(document_id).rating });
@@ -0,0 +1,45 @@
+#include "search_shard.h"
+
+LocalShard::LocalShard(std::string_view stop_words_text)
+    : search_server_(stop_words_text)
+{
+}
+
+std::vector<std::string> LocalShard::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+    const std::vector<int>& ratings)
+{
+    search_server_.AddDocument(document_id, document, status, ratings);
+    return GetDocumentWords(document_id);
+}
+
+std::vector<std::string> LocalShard::RemoveDocument(int document_id)
+{
+    std::vector<std::string> words = GetDocumentWords(document_id);
+    search_server_.RemoveDocument(document_id);
+    return words;
+}
+
+std::vector<Document> LocalShard::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const
+{
+    return search_server_.FindTopDocuments(raw_query, status);
+}
+
+shard_matched_documents LocalShard::MatchDocument(std::string_view raw_query, int document_id) const
+{
+    const auto [words, status] = search_server_.MatchDocument(raw_query, document_id);
+    return { std::vector<std::string>(words.begin(), words.end()), status };
+}
+
+void LocalShard::SetTermStatistics(const TermStatistics* term_statistics)
+{
+    search_server_.SetTermStatistics(term_statistics);
+}
+
+std::vector<std::string> LocalShard::GetDocumentWords(int document_id) const
+{
+    std::vector<std::string> words;
+    for (const auto& [word, _] : search_server_.GetWordFrequencies(document_id)) {
+        words.emplace_back(word);
+    }
+    return words;
+}
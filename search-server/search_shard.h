@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "search_server.h"
+
+using shard_matched_documents = std::tuple<std::vector<std::string>, DocumentStatus>;
+
+class SearchShard {
+public:
+    virtual ~SearchShard() = default;
+
+    // Returns the distinct words the shard indexed for the document.
+    virtual std::vector<std::string> AddDocument(int document_id, std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings) = 0;
+
+    // Returns the distinct words the removed document contributed to the index.
+    virtual std::vector<std::string> RemoveDocument(int document_id) = 0;
+
+    virtual std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const = 0;
+
+    virtual shard_matched_documents MatchDocument(std::string_view raw_query, int document_id) const = 0;
+
+    virtual void SetTermStatistics(const TermStatistics* term_statistics) = 0;
+};
+
+class LocalShard : public SearchShard {
+public:
+    explicit LocalShard(std::string_view stop_words_text);
+
+    std::vector<std::string> AddDocument(int document_id, std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings) override;
+
+    std::vector<std::string> RemoveDocument(int document_id) override;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const override;
+
+    shard_matched_documents MatchDocument(std::string_view raw_query, int document_id) const override;
+
+    void SetTermStatistics(const TermStatistics* term_statistics) override;
+
+private:
+    SearchServer search_server_;
+
+    std::vector<std::string> GetDocumentWords(int document_id) const;
+};
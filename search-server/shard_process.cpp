@@ -0,0 +1,321 @@
+#include "shard_process.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std::string_literals;
+
+namespace {
+
+    std::vector<std::string> SplitFields(std::string_view line, char separator) {
+        std::vector<std::string> fields;
+        size_t begin = 0;
+        while (true) {
+            const size_t end = line.find(separator, begin);
+            fields.emplace_back(line.substr(begin, end == std::string_view::npos ? end : end - begin));
+            if (end == std::string_view::npos) {
+                break;
+            }
+            begin = end + 1;
+        }
+        return fields;
+    }
+
+    std::vector<std::string> SplitWords(std::string_view text) {
+        std::vector<std::string> words;
+        if (!text.empty()) {
+            words = SplitFields(text, ' ');
+        }
+        return words;
+    }
+
+    template <typename Container>
+    std::string JoinFields(const Container& fields, char separator) {
+        std::string line;
+        bool first = true;
+        for (const auto& field : fields) {
+            if (!first) {
+                line += separator;
+            }
+            line += field;
+            first = false;
+        }
+        return line;
+    }
+
+    bool HasControlCharacters(std::string_view text) {
+        return std::any_of(text.begin(), text.end(), [](char c) {
+            return c >= '\0' && c < ' ';
+            });
+    }
+
+    std::string SanitizeMessage(std::string message) {
+        for (char& c : message) {
+            if (c >= '\0' && c < ' ') {
+                c = '?';
+            }
+        }
+        return message;
+    }
+
+    bool WriteAll(int socket, std::string_view data) {
+        while (!data.empty()) {
+            const ssize_t written = send(socket, data.data(), data.size(), MSG_NOSIGNAL);
+            if (written <= 0) {
+                return false;
+            }
+            data.remove_prefix(static_cast<size_t>(written));
+        }
+        return true;
+    }
+
+    bool ReadLine(int socket, std::string& buffer, std::string& line) {
+        size_t newline = buffer.find('\n');
+        while (newline == std::string::npos) {
+            char chunk[4096];
+            const ssize_t received = recv(socket, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                return false;
+            }
+            buffer.append(chunk, static_cast<size_t>(received));
+            newline = buffer.find('\n');
+        }
+        line = buffer.substr(0, newline);
+        buffer.erase(0, newline + 1);
+        return true;
+    }
+
+    std::string HandleShardRequest(LocalShard& shard, TermStatistics& query_statistics, const std::vector<std::string>& fields) {
+        const std::string& command = fields.at(0);
+        if (command == "ADD"s) {
+            std::vector<int> ratings;
+            for (const std::string& rating : SplitWords(fields.at(3))) {
+                ratings.push_back(std::stoi(rating));
+            }
+            const auto words = shard.AddDocument(std::stoi(fields.at(1)), fields.at(4),
+                static_cast<DocumentStatus>(std::stoi(fields.at(2))), ratings);
+            return JoinFields(words, ' ');
+        }
+        if (command == "REMOVE"s) {
+            return JoinFields(shard.RemoveDocument(std::stoi(fields.at(1))), ' ');
+        }
+        if (command == "FIND"s) {
+            query_statistics.Clear();
+            query_statistics.SetDocumentCount(std::stoi(fields.at(2)));
+            const auto word_counts = SplitWords(fields.at(3));
+            for (size_t i = 0; i + 1 < word_counts.size(); i += 2) {
+                query_statistics.SetWordDocumentCount(word_counts[i], std::stoi(word_counts[i + 1]));
+            }
+
+            std::ostringstream out;
+            out.precision(17);
+            bool first = true;
+            for (const Document& document : shard.FindTopDocuments(fields.at(4), static_cast<DocumentStatus>(std::stoi(fields.at(1))))) {
+                if (!first) {
+                    out << ' ';
+                }
+                out << document.id << ' ' << document.relevance << ' ' << document.rating;
+                first = false;
+            }
+            return out.str();
+        }
+        if (command == "MATCH"s) {
+            const auto [words, status] = shard.MatchDocument(fields.at(2), std::stoi(fields.at(1)));
+            return std::to_string(static_cast<int>(status)) + '\t' + JoinFields(words, ' ');
+        }
+        throw std::invalid_argument("Unknown shard command "s + command);
+    }
+
+}
+
+ProcessShard::ProcessShard(std::string_view stop_words_text, const std::vector<int>& inherited_sockets)
+{
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+        throw std::runtime_error("Unable to create shard socket"s);
+    }
+
+    pid_ = fork();
+    if (pid_ < 0) {
+        close(sockets[0]);
+        close(sockets[1]);
+        throw std::runtime_error("Unable to start shard process"s);
+    }
+
+    if (pid_ == 0) {
+        close(sockets[0]);
+        for (int socket : inherited_sockets) {
+            close(socket);
+        }
+        int exit_code = 0;
+        try {
+            ServeShard(sockets[1], stop_words_text);
+        }
+        catch (...) {
+            exit_code = 1;
+        }
+        _exit(exit_code);
+    }
+
+    close(sockets[1]);
+    socket_ = sockets[0];
+}
+
+ProcessShard::~ProcessShard()
+{
+    WriteAll(socket_, "QUIT\n"s);
+    close(socket_);
+    waitpid(pid_, nullptr, 0);
+}
+
+std::vector<std::string> ProcessShard::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+    const std::vector<int>& ratings)
+{
+    if (HasControlCharacters(document)) {
+        throw std::invalid_argument("Invalid document text"s);
+    }
+
+    std::vector<std::string> rating_fields;
+    for (int rating : ratings) {
+        rating_fields.push_back(std::to_string(rating));
+    }
+
+    const auto response = Request({ "ADD"s, std::to_string(document_id), std::to_string(static_cast<int>(status)),
+        JoinFields(rating_fields, ' '), std::string(document) });
+    return SplitWords(response.at(0));
+}
+
+std::vector<std::string> ProcessShard::RemoveDocument(int document_id)
+{
+    return SplitWords(Request({ "REMOVE"s, std::to_string(document_id) }).at(0));
+}
+
+std::vector<Document> ProcessShard::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const
+{
+    if (HasControlCharacters(raw_query)) {
+        throw std::invalid_argument("Invalid raw query"s);
+    }
+
+    std::vector<std::string> word_counts;
+    int document_count = 0;
+    if (term_statistics_ != nullptr) {
+        document_count = term_statistics_->GetDocumentCount();
+        for (std::string_view word : SplitIntoWords(raw_query)) {
+            if (!word.empty() && word[0] == '-') {
+                word.remove_prefix(1);
+            }
+            const int word_document_count = term_statistics_->GetWordDocumentCount(word);
+            if (word_document_count > 0) {
+                word_counts.emplace_back(word);
+                word_counts.push_back(std::to_string(word_document_count));
+            }
+        }
+    }
+
+    const auto response = Request({ "FIND"s, std::to_string(static_cast<int>(status)), std::to_string(document_count),
+        JoinFields(word_counts, ' '), std::string(raw_query) });
+
+    std::vector<Document> documents;
+    std::istringstream in(response.at(0));
+    Document document;
+    while (in >> document.id >> document.relevance >> document.rating) {
+        documents.push_back(document);
+    }
+    return documents;
+}
+
+shard_matched_documents ProcessShard::MatchDocument(std::string_view raw_query, int document_id) const
+{
+    if (HasControlCharacters(raw_query)) {
+        throw std::invalid_argument("Invalid raw query"s);
+    }
+
+    const auto response = Request({ "MATCH"s, std::to_string(document_id), std::string(raw_query) });
+    return { SplitWords(response.at(1)), static_cast<DocumentStatus>(std::stoi(response.at(0))) };
+}
+
+void ProcessShard::SetTermStatistics(const TermStatistics* term_statistics)
+{
+    term_statistics_ = term_statistics;
+}
+
+int ProcessShard::GetSocket() const
+{
+    return socket_;
+}
+
+std::vector<std::string> ProcessShard::Request(const std::vector<std::string>& fields) const
+{
+    std::lock_guard guard(mutex_);
+
+    std::string line;
+    if (!WriteAll(socket_, JoinFields(fields, '\t') + '\n') || !ReadLine(socket_, read_buffer_, line)) {
+        throw std::runtime_error("Shard process is not responding"s);
+    }
+
+    auto response = SplitFields(line, '\t');
+    if (response.at(0) == "ERR"s) {
+        const std::string& message = response.at(2);
+        if (response.at(1) == "invalid_argument"s) {
+            throw std::invalid_argument(message);
+        }
+        if (response.at(1) == "out_of_range"s) {
+            throw std::out_of_range(message);
+        }
+        throw std::runtime_error(message);
+    }
+    response.erase(response.begin());
+    return response;
+}
+
+std::vector<std::unique_ptr<SearchShard>> MakeProcessShards(size_t shard_count, std::string_view stop_words_text)
+{
+    std::vector<std::unique_ptr<SearchShard>> shards;
+    std::vector<int> sockets;
+    for (size_t i = 0; i < shard_count; ++i) {
+        auto shard = std::make_unique<ProcessShard>(stop_words_text, sockets);
+        sockets.push_back(shard->GetSocket());
+        shards.push_back(std::move(shard));
+    }
+    return shards;
+}
+
+void ServeShard(int socket, std::string_view stop_words_text)
+{
+    LocalShard shard(stop_words_text);
+    TermStatistics query_statistics;
+    shard.SetTermStatistics(&query_statistics);
+
+    std::string buffer;
+    std::string line;
+    while (ReadLine(socket, buffer, line)) {
+        const auto fields = SplitFields(line, '\t');
+        if (fields.at(0) == "QUIT"s) {
+            break;
+        }
+
+        std::string response;
+        try {
+            response = "OK\t"s + HandleShardRequest(shard, query_statistics, fields);
+        }
+        catch (const std::invalid_argument& e) {
+            response = "ERR\tinvalid_argument\t"s + SanitizeMessage(e.what());
+        }
+        catch (const std::out_of_range& e) {
+            response = "ERR\tout_of_range\t"s + SanitizeMessage(e.what());
+        }
+        catch (const std::exception& e) {
+            response = "ERR\truntime_error\t"s + SanitizeMessage(e.what());
+        }
+
+        if (!WriteAll(socket, response + '\n')) {
+            break;
+        }
+    }
+    close(socket);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "search_shard.h"
+
+// A shard living in a forked child process and reached over a local socket.
+// Requests are tab-separated lines; document and query text never contain
+// tabs or newlines because SearchServer rejects control characters anyway.
+class ProcessShard : public SearchShard {
+public:
+    ProcessShard(std::string_view stop_words_text, const std::vector<int>& inherited_sockets);
+
+    ProcessShard(const ProcessShard&) = delete;
+    ProcessShard& operator=(const ProcessShard&) = delete;
+
+    ~ProcessShard() override;
+
+    std::vector<std::string> AddDocument(int document_id, std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings) override;
+
+    std::vector<std::string> RemoveDocument(int document_id) override;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const override;
+
+    shard_matched_documents MatchDocument(std::string_view raw_query, int document_id) const override;
+
+    void SetTermStatistics(const TermStatistics* term_statistics) override;
+
+    int GetSocket() const;
+
+private:
+    int socket_ = -1;
+    pid_t pid_ = -1;
+    const TermStatistics* term_statistics_ = nullptr;
+    mutable std::mutex mutex_;
+    mutable std::string read_buffer_;
+
+    std::vector<std::string> Request(const std::vector<std::string>& fields) const;
+};
+
+std::vector<std::unique_ptr<SearchShard>> MakeProcessShards(size_t shard_count, std::string_view stop_words_text);
+
+void ServeShard(int socket, std::string_view stop_words_text);
@@ -0,0 +1,98 @@
+#include "sharded_search_server.h"
+
+ShardedSearchServer::ShardedSearchServer(size_t shard_count, std::string_view stop_words_text)
+{
+    if (shard_count == 0) {
+        throw std::invalid_argument("Shard count must be positive"s);
+    }
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<LocalShard>(stop_words_text));
+        shards_.back()->SetTermStatistics(&term_statistics_);
+    }
+}
+
+ShardedSearchServer::ShardedSearchServer(std::vector<std::unique_ptr<SearchShard>> shards)
+    : shards_(std::move(shards))
+{
+    if (shards_.empty()) {
+        throw std::invalid_argument("Shard count must be positive"s);
+    }
+    for (auto& shard : shards_) {
+        shard->SetTermStatistics(&term_statistics_);
+    }
+}
+
+void ShardedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+    const std::vector<int>& ratings)
+{
+    if ((document_id < 0) || (document_ids_.count(document_id) > 0)) {
+        throw std::invalid_argument("Invalid document_id"s);
+    }
+
+    const std::vector<std::string> words = GetShard(document_id).AddDocument(document_id, document, status, ratings);
+    term_statistics_.AddDocument(std::vector<std::string_view>(words.begin(), words.end()));
+    document_ids_.insert(document_id);
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const
+{
+    return FindTopDocuments(std::execution::par, raw_query, status);
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query) const
+{
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+int ShardedSearchServer::GetDocumentCount() const
+{
+    return static_cast<int>(document_ids_.size());
+}
+
+size_t ShardedSearchServer::GetShardCount() const
+{
+    return shards_.size();
+}
+
+typename std::set<int>::const_iterator ShardedSearchServer::begin() const
+{
+    return document_ids_.begin();
+}
+
+typename std::set<int>::const_iterator ShardedSearchServer::end() const
+{
+    return document_ids_.end();
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id)
+{
+    if (document_ids_.count(document_id) == 0) {
+        return;
+    }
+
+    const std::vector<std::string> words = GetShard(document_id).RemoveDocument(document_id);
+    term_statistics_.RemoveDocument(std::vector<std::string_view>(words.begin(), words.end()));
+    document_ids_.erase(document_id);
+}
+
+matched_documents ShardedSearchServer::MatchDocument(std::string_view raw_query, int document_id) const
+{
+    if (document_ids_.count(document_id) == 0) {
+        throw std::out_of_range("Nonexistent document id");
+    }
+
+    const auto [words, status] = GetShard(document_id).MatchDocument(raw_query, document_id);
+
+    // Matched words are always indexed words, so the statistics own a copy that outlives the call.
+    std::vector<std::string_view> matched_words;
+    for (const std::string& word : words) {
+        matched_words.push_back(term_statistics_.FindWord(word));
+    }
+    return { matched_words, status };
+}
+
+SearchShard& ShardedSearchServer::GetShard(int document_id) const
+{
+    const uint64_t hash = static_cast<uint64_t>(static_cast<uint32_t>(document_id)) * 0x9E3779B97F4A7C15ull;
+    return *shards_[(hash >> 32) % shards_.size()];
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <execution>
+#include <memory>
+#include <set>
+#include <string_view>
+#include <vector>
+
+#include "search_shard.h"
+#include "term_statistics.h"
+
+class ShardedSearchServer {
+public:
+    ShardedSearchServer(size_t shard_count, std::string_view stop_words_text);
+
+    explicit ShardedSearchServer(std::vector<std::unique_ptr<SearchShard>> shards);
+
+    ShardedSearchServer(const ShardedSearchServer&) = delete;
+    ShardedSearchServer& operator=(const ShardedSearchServer&) = delete;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings);
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentStatus status) const;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query) const;
+
+    int GetDocumentCount() const;
+
+    size_t GetShardCount() const;
+
+    typename std::set<int>::const_iterator begin() const;
+
+    typename std::set<int>::const_iterator end() const;
+
+    void RemoveDocument(int document_id);
+
+    matched_documents MatchDocument(std::string_view raw_query, int document_id) const;
+
+private:
+    std::vector<std::unique_ptr<SearchShard>> shards_;
+    TermStatistics term_statistics_;
+    std::set<int> document_ids_;
+
+    SearchShard& GetShard(int document_id) const;
+};
+
+template <typename ExecutionPolicy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentStatus status) const {
+    std::vector<std::vector<Document>> shard_documents(shards_.size());
+    std::vector<std::exception_ptr> shard_errors(shards_.size());
+
+    std::vector<size_t> shard_indexes(shards_.size());
+    for (size_t i = 0; i < shard_indexes.size(); ++i) {
+        shard_indexes[i] = i;
+    }
+
+    std::for_each(policy, shard_indexes.begin(), shard_indexes.end(),
+        [this, raw_query, status, &shard_documents, &shard_errors](size_t i) {
+            try {
+                shard_documents[i] = shards_[i]->FindTopDocuments(raw_query, status);
+            }
+            catch (...) {
+                shard_errors[i] = std::current_exception();
+            }
+        });
+
+    for (const std::exception_ptr& error : shard_errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::vector<Document> matched_documents;
+    for (const std::vector<Document>& documents : shard_documents) {
+        matched_documents.insert(matched_documents.end(), documents.begin(), documents.end());
+    }
+
+    std::sort(matched_documents.begin(), matched_documents.end(), IsRankedBefore);
+
+    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    }
+    return matched_documents;
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query) const {
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
@@ -1,20 +1,34 @@
 #include "string_processing.h"
 
+namespace {
+
+    template <typename Container>
+    void AppendWords(std::string_view text, Container& words)
+    {
+        int w_begin = 0;
+
+        while(w_begin <= text.length()) {
+            int w_end = text.find(' ', w_begin);
+
+            words.push_back(text.substr(w_begin, w_end - w_begin));
+            w_begin = (w_end == std::string_view::npos)
+                ? w_end
+                : w_end + 1;
+        }
+    }
+
+}
+
 std::vector<std::string_view> SplitIntoWords(std::string_view text)
 {
     std::vector<std::string_view> words;
-    
-    std::string_view word;
-    
-    int w_begin = 0;
-
-    while(w_begin <= text.length()) {
-        int w_end = text.find(' ', w_begin);
+    AppendWords(text, words);
+    return words;
+}
 
-        words.push_back(text.substr(w_begin, w_end - w_begin));
-        w_begin = (w_end == std::string_view::npos)
-            ? w_end
-            : w_end + 1;
-    }
+std::pmr::vector<std::string_view> SplitIntoWords(std::string_view text, std::pmr::memory_resource* resource)
+{
+    std::pmr::vector<std::string_view> words(resource);
+    AppendWords(text, words);
     return words;
 }
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <memory_resource>
 #include <string>
 #include <vector>
 #include <set>
 
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
 
+std::pmr::vector<std::string_view> SplitIntoWords(std::string_view text, std::pmr::memory_resource* resource);
+
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
     std::set<std::string, std::less<>> non_empty_strings;
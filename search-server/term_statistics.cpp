@@ -0,0 +1,65 @@
+#include "term_statistics.h"
+
+void TermStatistics::AddDocument(const std::vector<std::string_view>& words)
+{
+    ++document_count_;
+    for (std::string_view word : words) {
+        auto it = word_document_counts_.find(word);
+        if (it == word_document_counts_.end()) {
+            word_document_counts_.emplace(std::string(word), 1);
+        }
+        else {
+            ++it->second;
+        }
+    }
+}
+
+void TermStatistics::RemoveDocument(const std::vector<std::string_view>& words)
+{
+    --document_count_;
+    for (std::string_view word : words) {
+        auto it = word_document_counts_.find(word);
+        if (it != word_document_counts_.end() && --it->second == 0) {
+            word_document_counts_.erase(it);
+        }
+    }
+}
+
+void TermStatistics::SetDocumentCount(int document_count)
+{
+    document_count_ = document_count;
+}
+
+void TermStatistics::SetWordDocumentCount(std::string_view word, int document_count)
+{
+    auto it = word_document_counts_.find(word);
+    if (it == word_document_counts_.end()) {
+        word_document_counts_.emplace(std::string(word), document_count);
+    }
+    else {
+        it->second = document_count;
+    }
+}
+
+void TermStatistics::Clear()
+{
+    document_count_ = 0;
+    word_document_counts_.clear();
+}
+
+int TermStatistics::GetDocumentCount() const
+{
+    return document_count_;
+}
+
+int TermStatistics::GetWordDocumentCount(std::string_view word) const
+{
+    auto it = word_document_counts_.find(word);
+    return it == word_document_counts_.end() ? 0 : it->second;
+}
+
+std::string_view TermStatistics::FindWord(std::string_view word) const
+{
+    auto it = word_document_counts_.find(word);
+    return it == word_document_counts_.end() ? std::string_view() : std::string_view(it->first);
+}
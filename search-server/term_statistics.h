@@ -0,0 +1,29 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class TermStatistics {
+public:
+    void AddDocument(const std::vector<std::string_view>& words);
+
+    void RemoveDocument(const std::vector<std::string_view>& words);
+
+    void SetDocumentCount(int document_count);
+
+    void SetWordDocumentCount(std::string_view word, int document_count);
+
+    void Clear();
+
+    int GetDocumentCount() const;
+
+    int GetWordDocumentCount(std::string_view word) const;
+
+    std::string_view FindWord(std::string_view word) const;
+
+private:
+    int document_count_ = 0;
+    std::map<std::string, int, std::less<>> word_document_counts_;
+};
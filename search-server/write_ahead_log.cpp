@@ -0,0 +1,321 @@
+#include "write_ahead_log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "binary_io.h"
+#include "metrics.h"
+
+using namespace std::string_literals;
+
+namespace {
+    const size_t RECORD_HEADER_SIZE = 8;
+
+    std::runtime_error SystemError(const std::string& what) {
+        return std::runtime_error(what + ": "s + std::strerror(errno));
+    }
+
+    bool DecodeRecord(std::string_view payload, WalRecord& record) {
+        BinaryReader reader(payload);
+        uint8_t type = 0;
+        uint32_t document_id = 0;
+        if (!reader.ReadUint64(record.lsn) || !reader.ReadUint8(type) || !reader.ReadUint32(document_id)) {
+            return false;
+        }
+        record.document_id = static_cast<int>(document_id);
+        record.ratings.clear();
+        record.text = {};
+        if (type == static_cast<uint8_t>(WalRecordType::REMOVE_DOCUMENT)) {
+            record.type = WalRecordType::REMOVE_DOCUMENT;
+            return reader.IsEnd();
+        }
+        if (type != static_cast<uint8_t>(WalRecordType::ADD_DOCUMENT)) {
+            return false;
+        }
+        record.type = WalRecordType::ADD_DOCUMENT;
+        uint8_t status = 0;
+        uint32_t rating_count = 0;
+        if (!reader.ReadUint8(status) || !reader.ReadUint32(rating_count)) {
+            return false;
+        }
+        record.status = static_cast<DocumentStatus>(status);
+        for (uint32_t i = 0; i < rating_count; ++i) {
+            uint32_t rating = 0;
+            if (!reader.ReadUint32(rating)) {
+                return false;
+            }
+            record.ratings.push_back(static_cast<int>(rating));
+        }
+        return reader.ReadString(record.text) && reader.IsEnd();
+    }
+}
+
+WalReplayResult ReplayWriteAheadLog(const std::string& path, uint64_t min_lsn,
+    const std::function<void(const WalRecord&)>& apply)
+{
+    WalReplayResult result;
+    result.last_lsn = min_lsn;
+    std::string contents;
+    if (!ReadFileContents(path, contents)) {
+        return result;
+    }
+
+    BinaryReader reader(contents);
+    size_t valid_size = 0;
+    WalRecord record;
+    uint64_t previous_lsn = 0;
+    while (true) {
+        uint32_t payload_size = 0;
+        uint32_t checksum = 0;
+        std::string_view payload;
+        if (!reader.ReadUint32(payload_size) || !reader.ReadUint32(checksum)
+            || !reader.ReadBytes(payload_size, payload)
+            || ComputeCrc32(payload) != checksum
+            || !DecodeRecord(payload, record)
+            || record.lsn <= previous_lsn) {
+            break;
+        }
+        previous_lsn = record.lsn;
+        valid_size = reader.GetOffset();
+        if (record.lsn <= min_lsn) {
+            ++result.skipped_records;
+            continue;
+        }
+        apply(record);
+        result.last_lsn = record.lsn;
+        ++result.applied_records;
+    }
+
+    result.truncated_bytes = contents.size() - valid_size;
+    if (result.truncated_bytes > 0) {
+        if (truncate(path.c_str(), static_cast<off_t>(valid_size)) != 0) {
+            throw SystemError("Unable to truncate "s + path);
+        }
+    }
+    return result;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& path, Durability durability, uint64_t last_lsn)
+    : durability_(durability)
+    , last_lsn_(last_lsn)
+    , durable_lsn_(last_lsn)
+{
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd_ < 0) {
+        throw SystemError("Unable to open "s + path);
+    }
+    struct stat file_stat{};
+    if (fstat(fd_, &file_stat) != 0) {
+        close(fd_);
+        throw SystemError("Unable to stat "s + path);
+    }
+    written_size_ = file_stat.st_size;
+    try {
+        SyncParentDirectory(path);
+    }
+    catch (...) {
+        close(fd_);
+        throw;
+    }
+}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    try {
+        Sync();
+    }
+    catch (...) {
+    }
+    close(fd_);
+}
+
+uint64_t WriteAheadLog::AppendAddDocument(int document_id, std::string_view document, DocumentStatus status,
+    const std::vector<int>& ratings)
+{
+    std::string body;
+    body.reserve(document.size() + 4 * ratings.size() + 16);
+    AppendUint8(body, static_cast<uint8_t>(WalRecordType::ADD_DOCUMENT));
+    AppendUint32(body, static_cast<uint32_t>(document_id));
+    AppendUint8(body, static_cast<uint8_t>(status));
+    AppendUint32(body, static_cast<uint32_t>(ratings.size()));
+    for (int rating : ratings) {
+        AppendUint32(body, static_cast<uint32_t>(rating));
+    }
+    AppendString(body, document);
+    return Append(body);
+}
+
+uint64_t WriteAheadLog::AppendRemoveDocument(int document_id)
+{
+    std::string body;
+    AppendUint8(body, static_cast<uint8_t>(WalRecordType::REMOVE_DOCUMENT));
+    AppendUint32(body, static_cast<uint32_t>(document_id));
+    return Append(body);
+}
+
+uint64_t WriteAheadLog::Append(std::string_view body)
+{
+    std::unique_lock lock(mutex_);
+    if (failure_ != nullptr) {
+        std::rethrow_exception(failure_);
+    }
+    const uint64_t lsn = ++last_lsn_;
+
+    std::string payload;
+    payload.reserve(8 + body.size());
+    AppendUint64(payload, lsn);
+    payload.append(body);
+
+    const size_t record_start = pending_.size();
+    pending_.reserve(record_start + RECORD_HEADER_SIZE + payload.size());
+    AppendUint32(pending_, static_cast<uint32_t>(payload.size()));
+    AppendUint32(pending_, ComputeCrc32(payload));
+    pending_.append(payload);
+
+    if (durability_ != Durability::GROUP) {
+        // Nothing else is pending under NONE and SYNC, so this writes just the
+        // new record. Holding the lock keeps records in LSN order on disk.
+        try {
+            WriteAll(fd_, pending_);
+            if (durability_ == Durability::SYNC && fdatasync(fd_) != 0) {
+                throw SystemError("Unable to sync write-ahead log"s);
+            }
+        }
+        catch (...) {
+            FailLocked();
+        }
+        written_size_ += static_cast<off_t>(pending_.size());
+        pending_.clear();
+        if (durability_ == Durability::SYNC) {
+            METRICS_COUNT(MetricCounter::WAL_SYNCS, 1);
+            durable_lsn_ = lsn;
+            ++sync_count_;
+        }
+    }
+    return lsn;
+}
+
+void WriteAheadLog::WaitDurable(uint64_t lsn)
+{
+    if (durability_ != Durability::GROUP) {
+        return;
+    }
+    std::unique_lock lock(mutex_);
+    while (durable_lsn_ < lsn) {
+        if (failure_ != nullptr) {
+            std::rethrow_exception(failure_);
+        }
+        if (syncing_) {
+            synced_.wait(lock);
+        }
+        else {
+            SyncLocked(lock);
+        }
+    }
+}
+
+void WriteAheadLog::Sync()
+{
+    std::unique_lock lock(mutex_);
+    synced_.wait(lock, [this] { return !syncing_; });
+    if (durable_lsn_ < last_lsn_ || !pending_.empty()) {
+        if (failure_ != nullptr) {
+            std::rethrow_exception(failure_);
+        }
+        SyncLocked(lock);
+    }
+}
+
+void WriteAheadLog::SyncLocked(std::unique_lock<std::mutex>& lock)
+{
+    std::string batch;
+    batch.swap(pending_);
+    const uint64_t batch_lsn = last_lsn_;
+    syncing_ = true;
+    // Writers keep appending to pending_ while this batch is written and synced.
+    lock.unlock();
+    try {
+        WriteAll(fd_, batch);
+        if (fdatasync(fd_) != 0) {
+            throw SystemError("Unable to sync write-ahead log"s);
+        }
+    }
+    catch (...) {
+        lock.lock();
+        syncing_ = false;
+        // Records appended meanwhile are dropped too: they can never become
+        // durable, and their waiters get the error.
+        pending_.clear();
+        FailLocked();
+    }
+    METRICS_COUNT(MetricCounter::WAL_SYNCS, 1);
+    lock.lock();
+    written_size_ += static_cast<off_t>(batch.size());
+    syncing_ = false;
+    durable_lsn_ = std::max(durable_lsn_, batch_lsn);
+    ++sync_count_;
+    synced_.notify_all();
+}
+
+void WriteAheadLog::Reset()
+{
+    std::unique_lock lock(mutex_);
+    synced_.wait(lock, [this] { return !syncing_; });
+    if (failure_ != nullptr) {
+        std::rethrow_exception(failure_);
+    }
+    pending_.clear();
+    try {
+        if (ftruncate(fd_, 0) != 0 || fdatasync(fd_) != 0) {
+            throw SystemError("Unable to reset write-ahead log"s);
+        }
+    }
+    catch (...) {
+        FailLocked();
+    }
+    written_size_ = 0;
+    durable_lsn_ = last_lsn_;
+    synced_.notify_all();
+}
+
+uint64_t WriteAheadLog::GetLastLsn() const
+{
+    std::lock_guard lock(mutex_);
+    return last_lsn_;
+}
+
+uint64_t WriteAheadLog::GetDurableLsn() const
+{
+    std::lock_guard lock(mutex_);
+    return durable_lsn_;
+}
+
+void WriteAheadLog::FailLocked()
+{
+    failure_ = std::current_exception();
+    // Best effort: a torn record left mid-file would make replay drop every
+    // record after it, so cut the file back to the last complete one.
+    struct stat file_stat{};
+    if (fstat(fd_, &file_stat) == 0 && file_stat.st_size > written_size_ && ftruncate(fd_, written_size_) == 0) {
+        fdatasync(fd_);
+    }
+    synced_.notify_all();
+    std::rethrow_exception(failure_);
+}
+
+Durability WriteAheadLog::GetDurability() const
+{
+    return durability_;
+}
+
+size_t WriteAheadLog::GetSyncCount() const
+{
+    std::lock_guard lock(mutex_);
+    return sync_count_;
+}
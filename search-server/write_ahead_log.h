@@ -0,0 +1,119 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "document.h"
+
+// What a successful append promises once WaitDurable returns.
+enum class Durability {
+    // Written to the OS: survives a process crash, not a power loss.
+    NONE,
+    // Fsynced; concurrent writers share one fsync (group commit).
+    GROUP,
+    // Fsynced on every append before it returns.
+    SYNC,
+};
+
+enum class WalRecordType : uint8_t {
+    ADD_DOCUMENT = 1,
+    REMOVE_DOCUMENT = 2,
+};
+
+struct WalRecord {
+    uint64_t lsn = 0;
+    WalRecordType type = WalRecordType::ADD_DOCUMENT;
+    int document_id = 0;
+    // Only set for ADD_DOCUMENT.
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+    std::string_view text;
+};
+
+struct WalReplayResult {
+    uint64_t last_lsn = 0;
+    size_t applied_records = 0;
+    size_t skipped_records = 0;
+    size_t truncated_bytes = 0;
+};
+
+// Calls apply for every intact record with an LSN above min_lsn, in log order.
+// Reading stops at the first torn, corrupt or out-of-order record, and the file
+// is truncated there, so the next append starts on a record boundary. A
+// missing file replays nothing.
+WalReplayResult ReplayWriteAheadLog(const std::string& path, uint64_t min_lsn,
+    const std::function<void(const WalRecord&)>& apply);
+
+// Append-only log of index mutations. Each record is framed as
+// [payload size][CRC-32 of payload][payload] and carries a log sequence number
+// (LSN) that increases by one per record and keeps increasing across Reset.
+//
+// A failed write or fsync fails the log for good: whatever was not yet durable
+// is cut from the file, and every later call that needs the disk rethrows the
+// error, including WaitDurable for records above GetDurableLsn. Reopen the log
+// to continue.
+class WriteAheadLog {
+public:
+    // Creates the file if needed and fsyncs its directory.
+    WriteAheadLog(const std::string& path, Durability durability, uint64_t last_lsn);
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Syncs whatever was appended but not yet written.
+    ~WriteAheadLog();
+
+    uint64_t AppendAddDocument(int document_id, std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings);
+
+    uint64_t AppendRemoveDocument(int document_id);
+
+    // Blocks until the record is as durable as the log's level promises. Only
+    // GROUP defers work to here: the first waiter writes and fsyncs every
+    // pending record while the others wait for it.
+    void WaitDurable(uint64_t lsn);
+
+    // Writes and fsyncs everything appended so far, whatever the level.
+    void Sync();
+
+    // Empties the log once a snapshot covers every record in it.
+    void Reset();
+
+    uint64_t GetLastLsn() const;
+
+    uint64_t GetDurableLsn() const;
+
+    Durability GetDurability() const;
+
+    size_t GetSyncCount() const;
+
+private:
+    int fd_ = -1;
+    Durability durability_;
+    mutable std::mutex mutex_;
+    std::condition_variable synced_;
+    uint64_t last_lsn_;
+    uint64_t durable_lsn_;
+    std::string pending_;
+    bool syncing_ = false;
+    size_t sync_count_ = 0;
+    // Bytes of complete records in the file; a failure truncates back to it.
+    off_t written_size_ = 0;
+    std::exception_ptr failure_;
+
+    // The body is the payload without its LSN, which is assigned here.
+    uint64_t Append(std::string_view body);
+
+    void SyncLocked(std::unique_lock<std::mutex>& lock);
+
+    // Called with the lock held from inside a catch block; rethrows.
+    [[noreturn]] void FailLocked();
+};